@@ -4,26 +4,33 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 FragPos;
 
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 camera_pos;
+    vec4 light_pos;
+    vec4 light_color;
+};
+
 uniform vec3 objectColor;
-uniform vec3 lightColor;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
 
 void main()
 {
     // ambient
     float ambientStrength = 0.1;
+    vec3 lightColor = light_color.xyz;
     vec3 ambient = ambientStrength * lightColor;
 
     // diffuse
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(light_pos.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
 
     // specular lighting
     float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(camera_pos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
     vec3 specular = specularStrength * spec * lightColor;
@@ -2,17 +2,26 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 camera_pos;
+    vec4 light_pos;
+    vec4 light_color;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Inverse-transpose of the model's upper 3x3, computed on the CPU
+uniform mat3 normalMatrix;
 
 out vec3 Normal;
 out vec3 FragPos;
 
 void main()
 {
-    Normal = aNormal;
+    Normal = aNormal * normalMatrix;
     FragPos = vec3(vec4(aPos, 1.0) * model);
 
-	gl_Position = vec4(FragPos, 1.0) * view * projection;
+	gl_Position = vec4(FragPos, 1.0) * view_proj;
 }
@@ -1,11 +1,18 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 camera_pos;
+    vec4 light_pos;
+    vec4 light_color;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
-	gl_Position = vec4(aPos, 1.0) * model * view * projection;
+	gl_Position = vec4(aPos, 1.0) * model * view_proj;
 }
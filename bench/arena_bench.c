@@ -0,0 +1,41 @@
+#include "cutils.h"
+#include "bench.h"
+
+#define ALLOCS_PER_FRAME 1000000
+#define FRAMES 16
+
+// One frame of small allocations followed by a reset, the steady-state
+// pattern arena_reset folds regions for
+int main(void)
+{
+    Arena arena = {0};
+    double steady = 0.0;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        double start = bench_now();
+        for (size_t i = 0; i < ALLOCS_PER_FRAME; ++i) {
+            uint64_t *p = arena_alloc(&arena, 16);
+            p[0] = i;
+            bench_sink += p[0];
+        }
+        double elapsed = bench_now() - start;
+        if (frame == 0) bench_report("arena first frame", elapsed, ALLOCS_PER_FRAME, "allocs");
+        else steady += elapsed;
+        arena_reset(&arena);
+    }
+    bench_report("arena steady frames", steady, (double)ALLOCS_PER_FRAME*(FRAMES - 1), "allocs");
+    arena_free(&arena);
+
+    static void *ptrs[ALLOCS_PER_FRAME];
+    double start = bench_now();
+    for (int frame = 1; frame < FRAMES; ++frame) {
+        for (size_t i = 0; i < ALLOCS_PER_FRAME; ++i) {
+            uint64_t *p = malloc(16);
+            p[0] = i;
+            bench_sink += p[0];
+            ptrs[i] = p;
+        }
+        for (size_t i = 0; i < ALLOCS_PER_FRAME; ++i) free(ptrs[i]);
+    }
+    bench_report("malloc/free frames", bench_now() - start, (double)ALLOCS_PER_FRAME*(FRAMES - 1), "allocs");
+    return 0;
+}
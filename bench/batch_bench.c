@@ -0,0 +1,76 @@
+#define GM_IMPLEMENTATION
+#include "gm.h"
+#include "bench.h"
+
+#include <stdlib.h>
+
+#define INSTANCES 100000
+#define ROUNDS 50
+
+// mat4_batch_model and mat4_batch_mvp on 100k SoA instances against the
+// per-instance eye + translate + rotate + scale chain they replace
+int main(void)
+{
+    float *soa = malloc(sizeof(float)*10*INSTANCES);
+    float *px = soa, *py = px + INSTANCES, *pz = py + INSTANCES;
+    float *qx = pz + INSTANCES, *qy = qx + INSTANCES, *qz = qy + INSTANCES, *qw = qz + INSTANCES;
+    float *sx = qw + INSTANCES, *sy = sx + INSTANCES, *sz = sy + INSTANCES;
+    Mat4 *batch = malloc(sizeof(Mat4)*INSTANCES);
+    Mat4 *single = malloc(sizeof(Mat4)*INSTANCES);
+    uint64_t state = 7;
+    for(size_t i = 0; i < INSTANCES; ++i) {
+        px[i] = bench_randf(&state, -100.0f, 100.0f);
+        py[i] = bench_randf(&state, -10.0f, 10.0f);
+        pz[i] = bench_randf(&state, -100.0f, 100.0f);
+        Quat q = quat_from_axis_angle(vec3_normalize(vec3(bench_randf(&state, -1.0f, 1.0f), 1.0f, bench_randf(&state, -1.0f, 1.0f))),
+                bench_randf(&state, -PI, PI));
+        qx[i] = q.x; qy[i] = q.y; qz[i] = q.z; qw[i] = q.w;
+        sx[i] = sy[i] = sz[i] = bench_randf(&state, 0.5f, 2.0f);
+    }
+    TransformSoA transforms = { px, py, pz, qx, qy, qz, qw, sx, sy, sz };
+    Mat4 view_proj = mat4_dot(mat4_perspective(0.8f, 16.0f/9.0f, 0.1f, 500.0f),
+            mat4_look_at(vec3(0.0f, 50.0f, 150.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f)));
+
+    double start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < INSTANCES; ++i) {
+            Mat4 model = mat4_translate(mat4_eye(1.0f), vec3(px[i], py[i], pz[i]));
+            model = mat4_rotate(model, (Quat){ qx[i], qy[i], qz[i], qw[i] });
+            single[i] = mat4_scale(model, vec3(sx[i], sy[i], sz[i]));
+        }
+    }
+    bench_report("eye+translate+rotate+scale", bench_now() - start, (double)INSTANCES*ROUNDS, "matrices");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) mat4_batch_model(batch, transforms, INSTANCES);
+    bench_report("mat4_batch_model", bench_now() - start, (double)INSTANCES*ROUNDS, "matrices");
+
+    float max_error = 0.0f;
+    for(size_t i = 0; i < INSTANCES; ++i) {
+        for(int j = 0; j < 16; ++j) max_error = fmaxf(max_error, fabsf(batch[i].data[j] - single[i].data[j]));
+    }
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        mat4_batch_model(single, transforms, INSTANCES);
+        for(size_t i = 0; i < INSTANCES; ++i) single[i] = mat4_dot(view_proj, single[i]);
+    }
+    bench_report("batch_model + mat4_dot", bench_now() - start, (double)INSTANCES*ROUNDS, "matrices");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) mat4_batch_mvp(batch, view_proj, transforms, INSTANCES);
+    bench_report("mat4_batch_mvp", bench_now() - start, (double)INSTANCES*ROUNDS, "matrices");
+
+    for(size_t i = 0; i < INSTANCES; ++i) {
+        for(int j = 0; j < 16; ++j) {
+            float scale = fmaxf(1.0f, fabsf(single[i].data[j]));
+            max_error = fmaxf(max_error, fabsf(batch[i].data[j] - single[i].data[j])/scale);
+        }
+    }
+    printf("max error against the per-instance path: %g\n", max_error);
+    bench_sink += (uint64_t)batch[INSTANCES/2].data[3];
+    free(single);
+    free(batch);
+    free(soa);
+    return max_error < 1e-4f ? 0 : 1;
+}
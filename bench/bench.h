@@ -0,0 +1,74 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Shared helpers for the programs in bench/. Every benchmark is a plain
+// executable built by `make bench` that prints one line per measurement.
+
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+// Peak resident set size of the process so far, in bytes
+static inline size_t bench_peak_rss(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return pmc.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) < 0) return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss*1024;
+#endif
+#endif
+}
+
+// Keeps the optimizer from dropping work whose result is otherwise unused
+static volatile uint64_t bench_sink;
+
+static inline void bench_report(const char *name, double seconds, double ops, const char *unit)
+{
+    printf("%-32s %10.3f ms %10.2f M %s/s %8.2f ns/op\n",
+            name, seconds*1e3, ops/seconds*1e-6, unit, seconds*1e9/ops);
+}
+
+static inline void bench_report_bytes(const char *name, double seconds, double bytes)
+{
+    printf("%-32s %10.3f ms %10.2f MB/s\n", name, seconds*1e3, bytes/seconds*1e-6);
+}
+
+// xorshift64, so runs are reproducible without depending on rand()
+static inline uint64_t bench_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static inline float bench_randf(uint64_t *state, float lo, float hi)
+{
+    return lo + (hi - lo)*(float)(bench_rand(state) >> 40)*(1.0f/16777216.0f);
+}
+
+#endif // BENCH_H_
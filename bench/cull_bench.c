@@ -0,0 +1,50 @@
+#define GM_IMPLEMENTATION
+#include "gm.h"
+#include "bench.h"
+
+#include <stdlib.h>
+
+#define BOXES 1000000
+#define ROUNDS 20
+
+// frustum_cull_aabbs on 1M boxes against one frustum_test_aabb per box.
+// The SIMD mask must match the scalar test bit for bit, the program fails
+// otherwise. Built for SSE, AVX and scalar.
+int main(void)
+{
+    AABB *boxes = malloc(sizeof(AABB)*BOXES);
+    uint32_t *mask = malloc(sizeof(uint32_t)*((BOXES + 31)/32));
+    uint64_t state = 5;
+    for(size_t i = 0; i < BOXES; ++i) {
+        Vec3 c = vec3(bench_randf(&state, -200.0f, 200.0f), bench_randf(&state, -20.0f, 20.0f), bench_randf(&state, -200.0f, 200.0f));
+        Vec3 e = vec3(bench_randf(&state, 0.1f, 4.0f), bench_randf(&state, 0.1f, 4.0f), bench_randf(&state, 0.1f, 4.0f));
+        boxes[i] = (AABB){ vec3_sub(c, e), vec3_add(c, e) };
+    }
+    Mat4 view_proj = mat4_dot(mat4_perspective(1.0f, 16.0f/9.0f, 0.1f, 150.0f),
+            mat4_look_at(vec3(0.0f, 10.0f, 0.0f), vec3(30.0f, 0.0f, -50.0f), vec3(0.0f, 1.0f, 0.0f)));
+    Frustum frustum = frustum_from_view_proj(view_proj);
+
+    size_t visible = 0;
+    double start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        visible = 0;
+        for(size_t i = 0; i < BOXES; ++i) visible += frustum_test_aabb(&frustum, boxes[i]);
+    }
+    bench_report("frustum_test_aabb per box", bench_now() - start, (double)BOXES*ROUNDS, "boxes");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) frustum_cull_aabbs(&frustum, boxes, BOXES, mask);
+    bench_report("frustum_cull_aabbs", bench_now() - start, (double)BOXES*ROUNDS, "boxes");
+
+    size_t mismatches = 0, mask_visible = 0;
+    for(size_t i = 0; i < BOXES; ++i) {
+        bool bit = (mask[i/32] >> (i%32)) & 1;
+        mask_visible += bit;
+        if(bit != frustum_test_aabb(&frustum, boxes[i])) mismatches += 1;
+    }
+    printf("visible %zu of %d boxes, %zu mask mismatches\n", mask_visible, BOXES, mismatches);
+    bench_sink += visible;
+    free(mask);
+    free(boxes);
+    return mismatches == 0 && mask_visible == visible ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include "cutils.h"
+#include "bench.h"
+
+#define APPENDS 50000000
+#define ROUNDS 4
+
+typedef struct {
+    uint32_t *items;
+    size_t count;
+    size_t capacity;
+} U32s;
+
+// da_reserve as it was before growth went through CUT_REALLOC: always
+// doubling into a fresh CUT_MALLOC block and copying the old items over
+#define old_da_reserve(da, required_cap)                            \
+    do {                                                            \
+        size_t item_size = sizeof(*(da)->items);                    \
+        if(required_cap > (da)->capacity) {                         \
+            if((da)->capacity == 0) (da)->capacity = DA_INIT_CAP;   \
+            while((da)->capacity < required_cap)                    \
+                (da)->capacity *= 2;                                \
+            void *items = CUT_MALLOC((da)->capacity * item_size);   \
+            CUT_ASSERT(items != NULL && "Buy More RAM LOL!");       \
+            if((da)->items) {                                       \
+                memcpy(items, (da)->items, (da)->count*item_size);  \
+                CUT_FREE((da)->items);                              \
+            }                                                       \
+            (da)->items = items;                                    \
+        }                                                           \
+    } while(0)
+
+#define old_da_append(da, item)                                     \
+    do {                                                            \
+        old_da_reserve((da), (da)->count + 1);                      \
+        (da)->items[(da)->count++] = (item);                        \
+    } while(0)
+
+// Peak RSS only grows, so run `da_bench old` and `da_bench new` as separate
+// processes to compare it. Without an argument both are timed.
+int main(int argc, char **argv)
+{
+    const char *mode = argc > 1 ? argv[1] : "both";
+    bool run_old = strcmp(mode, "new") != 0;
+    bool run_new = strcmp(mode, "old") != 0;
+
+    if (run_old) {
+        double start = bench_now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            U32s xs = {0};
+            for (uint32_t i = 0; i < APPENDS; ++i) old_da_append(&xs, i);
+            bench_sink += xs.items[xs.count - 1];
+            da_free(&xs);
+        }
+        bench_report("old da_append (malloc+copy)", bench_now() - start, (double)APPENDS*ROUNDS, "appends");
+    }
+    if (run_new) {
+        double start = bench_now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            U32s xs = {0};
+            for (uint32_t i = 0; i < APPENDS; ++i) da_append(&xs, i);
+            bench_sink += xs.items[xs.count - 1];
+            da_free(&xs);
+        }
+        bench_report("da_append (CUT_REALLOC)", bench_now() - start, (double)APPENDS*ROUNDS, "appends");
+    }
+    printf("peak RSS (%s): %.1f MiB\n", mode, (double)bench_peak_rss()/(1024.0*1024.0));
+    return 0;
+}
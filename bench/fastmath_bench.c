@@ -0,0 +1,84 @@
+#define GM_IMPLEMENTATION
+#include "gm.h"
+#include "bench.h"
+
+#include <stdlib.h>
+
+#define SAMPLES 1000000
+#define ROUNDS 20
+
+// Precision and speed of the opt-in fast math over 1M random inputs. The
+// error is measured against double precision libm and checked against the
+// bounds documented in gm.h, so a regression makes the program fail.
+int main(void)
+{
+    float *angles = malloc(sizeof(float)*SAMPLES);
+    float *values = malloc(sizeof(float)*SAMPLES);
+    uint64_t state = 11;
+    for(size_t i = 0; i < SAMPLES; ++i) {
+        angles[i] = bench_randf(&state, -8192.0f, 8192.0f);
+        values[i] = bench_randf(&state, 1e-4f, 1e4f);
+    }
+
+    double sincos_error = 0.0;
+    double rsqrt_error = 0.0;
+    for(size_t i = 0; i < SAMPLES; ++i) {
+        float s, c;
+        gm_sincos_fast(angles[i], &s, &c);
+        sincos_error = fmax(sincos_error, fabs(s - sin((double)angles[i])));
+        sincos_error = fmax(sincos_error, fabs(c - cos((double)angles[i])));
+        double exact = 1.0/sqrt((double)values[i]);
+        rsqrt_error = fmax(rsqrt_error, fabs(gm_rsqrt_fast(values[i]) - exact)/exact);
+    }
+    printf("gm_sincos_fast max abs error |x| <= 8192: %.3g\n", sincos_error);
+    printf("gm_rsqrt_fast max rel error:             %.3g\n", rsqrt_error);
+
+    float acc = 0.0f;
+    double start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < SAMPLES; ++i) {
+            float s, c;
+            gm_sincos_fast(angles[i], &s, &c);
+            acc += s + c;
+        }
+    }
+    bench_report("gm_sincos_fast", bench_now() - start, (double)SAMPLES*ROUNDS, "ops");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < SAMPLES; ++i) {
+            float s, c;
+            gm_sincos(angles[i], &s, &c);
+            acc += s + c;
+        }
+    }
+    bench_report("gm_sincos (sinf+cosf)", bench_now() - start, (double)SAMPLES*ROUNDS, "ops");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < SAMPLES; ++i) acc += (float)(sin((double)angles[i]) + cos((double)angles[i]));
+    }
+    bench_report("double sin+cos", bench_now() - start, (double)SAMPLES*ROUNDS, "ops");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < SAMPLES; ++i) acc += gm_rsqrt_fast(values[i]);
+    }
+    bench_report("gm_rsqrt_fast", bench_now() - start, (double)SAMPLES*ROUNDS, "ops");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < SAMPLES; ++i) acc += 1.0f/sqrtf(values[i]);
+    }
+    bench_report("1/sqrtf", bench_now() - start, (double)SAMPLES*ROUNDS, "ops");
+
+    bench_sink += (uint64_t)acc;
+    free(values);
+    free(angles);
+#ifdef GM_SSE
+    double rsqrt_bound = 5e-7;
+#else
+    double rsqrt_bound = 1.2e-7;
+#endif
+    return sincos_error <= 1e-7 && rsqrt_error <= rsqrt_bound ? 0 : 1;
+}
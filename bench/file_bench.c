@@ -0,0 +1,63 @@
+#include "cutils.h"
+#include "bench.h"
+
+#define FILE_SIZE (256u*1024u*1024u)
+#define ROUNDS 4
+
+static uint64_t checksum(const unsigned char *data, size_t size)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 4096) sum += data[i];
+    return sum;
+}
+
+// Reads a warm FILE_SIZE file whole with read_entire_file and in chunks
+// with FileReader. Pass a path to use an existing file instead.
+int main(int argc, char **argv)
+{
+    const char *filepath = argc > 1 ? argv[1] : "file_bench.tmp";
+    size_t size = FILE_SIZE;
+    if (argc <= 1) {
+        unsigned char *data = malloc(FILE_SIZE);
+        uint64_t state = 0x9e3779b97f4a7c15ull;
+        for (size_t i = 0; i < FILE_SIZE; ++i) data[i] = (unsigned char)bench_rand(&state);
+        if (!write_entire_file(filepath, data, FILE_SIZE)) return 1;
+        free(data);
+    } else {
+        FileReader reader;
+        if (!file_reader_open(filepath, &reader)) return 1;
+        size = reader.size;
+        file_reader_close(&reader);
+    }
+
+    double start = bench_now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        StringBuilder sb = {0};
+        if (!read_entire_file(filepath, &sb)) return 1;
+        bench_sink += checksum((unsigned char*)sb.items, sb.count);
+        sb_free(&sb);
+    }
+    bench_report_bytes("read_entire_file", bench_now() - start, (double)size*ROUNDS);
+
+    static const size_t chunk_sizes[] = { 16*1024, 64*1024, 1024*1024 };
+    for (size_t c = 0; c < ARRAY_LEN(chunk_sizes); ++c) {
+        unsigned char *buffer = malloc(chunk_sizes[c]);
+        start = bench_now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            FileReader reader;
+            if (!file_reader_open(filepath, &reader)) return 1;
+            size_t n;
+            while (file_reader_read(&reader, buffer, chunk_sizes[c], &n) && n > 0) {
+                bench_sink += checksum(buffer, n);
+            }
+            file_reader_close(&reader);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "FileReader %zu KiB chunks", chunk_sizes[c]/1024);
+        bench_report_bytes(name, bench_now() - start, (double)size*ROUNDS);
+        free(buffer);
+    }
+
+    if (argc <= 1) remove(filepath);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "cutils.h"
+#include "bench.h"
+
+HASHMAP_DECLARE(IntMap, intmap, uint64_t, uint64_t)
+HASHMAP_DEFINE(IntMap, intmap, uint64_t, uint64_t, hash_u64, HASHMAP_EQ_SCALAR)
+
+#define LOOKUPS 1000000
+// Elements the linear scan may touch per size, so 10M keys stay bearable
+#define SCAN_BUDGET 200000000ull
+
+typedef struct {
+    uint64_t key;
+    uint64_t value;
+} Pair;
+
+int main(void)
+{
+    static const size_t sizes[] = { 10000, 100000, 1000000, 10000000 };
+    for (size_t s = 0; s < ARRAY_LEN(sizes); ++s) {
+        size_t n = sizes[s];
+        Pair *pairs = malloc(n*sizeof(*pairs));
+        uint64_t state = 0x2545f4914f6cdd1dull + n;
+        for (size_t i = 0; i < n; ++i) {
+            pairs[i].key = bench_rand(&state);
+            pairs[i].value = i;
+        }
+        printf("%zu keys\n", n);
+
+        IntMap map = {0};
+        double start = bench_now();
+        for (size_t i = 0; i < n; ++i) intmap_put(&map, pairs[i].key, pairs[i].value);
+        bench_report("  intmap_put", bench_now() - start, (double)n, "ops");
+
+        start = bench_now();
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            uint64_t *v = intmap_get(&map, pairs[bench_rand(&state) % n].key);
+            bench_sink += *v;
+        }
+        bench_report("  intmap_get hit", bench_now() - start, LOOKUPS, "ops");
+
+        start = bench_now();
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            bench_sink += intmap_get(&map, bench_rand(&state)) != NULL;
+        }
+        bench_report("  intmap_get miss", bench_now() - start, LOOKUPS, "ops");
+
+        size_t scans = SCAN_BUDGET/n;
+        if (scans > LOOKUPS) scans = LOOKUPS;
+        start = bench_now();
+        for (size_t i = 0; i < scans; ++i) {
+            uint64_t key = pairs[bench_rand(&state) % n].key;
+            for (size_t j = 0; j < n; ++j) {
+                if (pairs[j].key == key) {
+                    bench_sink += pairs[j].value;
+                    break;
+                }
+            }
+        }
+        bench_report("  linear scan hit", bench_now() - start, (double)scans, "ops");
+
+        intmap_free(&map);
+        free(pairs);
+    }
+    return 0;
+}
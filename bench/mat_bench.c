@@ -0,0 +1,61 @@
+#define GM_IMPLEMENTATION
+#include "gm.h"
+#include "bench.h"
+
+#define INSTANCES 1024
+#define ROUNDS 2000
+
+// The per-object path of the game loop: build each model matrix with
+// translate/rotate/scale, then multiply it by the view-projection. Build as
+// mat_bench (SSE), mat_bench_scalar and mat_bench_avx to compare the paths.
+int main(void)
+{
+#if defined(GM_AVX)
+    const char *path = "avx";
+#elif defined(GM_SSE)
+    const char *path = "sse";
+#else
+    const char *path = "scalar";
+#endif
+    static Vec3 positions[INSTANCES];
+    static float angles[INSTANCES];
+    static Mat4 models[INSTANCES];
+    static Mat4 mvps[INSTANCES];
+    uint64_t state = 42;
+    for(size_t i = 0; i < INSTANCES; ++i) {
+        positions[i] = vec3(bench_randf(&state, -50.0f, 50.0f), bench_randf(&state, -5.0f, 5.0f), bench_randf(&state, -50.0f, 50.0f));
+        angles[i] = bench_randf(&state, -PI, PI);
+    }
+    Mat4 view_proj = mat4_dot(mat4_perspective(0.8f, 16.0f/9.0f, 0.1f, 100.0f),
+            mat4_look_at(vec3(0.0f, 10.0f, 20.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f)));
+    printf("path: %s\n", path);
+
+    double start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < INSTANCES; ++i) {
+            Mat4 model = mat4_translate(mat4_eye(1.0f), positions[i]);
+            model = mat4_rotate_y(model, angles[i]);
+            models[i] = mat4_scale(model, vec3(0.5f, 0.5f, 0.5f));
+        }
+        bench_sink += (uint64_t)models[round % INSTANCES].data[3];
+    }
+    bench_report("model matrices", bench_now() - start, (double)INSTANCES*ROUNDS, "matrices");
+
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < INSTANCES; ++i) mvps[i] = mat4_dot(view_proj, models[i]);
+        bench_sink += (uint64_t)mvps[round % INSTANCES].data[3];
+    }
+    bench_report("view_proj x model (mat4_dot)", bench_now() - start, (double)INSTANCES*ROUNDS, "matrices");
+
+    Vec4 acc = vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    start = bench_now();
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < INSTANCES; ++i) {
+            acc = vec4_add(acc, mat4_mul_vec4(mvps[i], vec4(1.0f, 1.0f, 1.0f, 1.0f)));
+        }
+    }
+    bench_sink += (uint64_t)acc.x;
+    bench_report("mat4_mul_vec4", bench_now() - start, (double)INSTANCES*ROUNDS, "vectors");
+    return 0;
+}
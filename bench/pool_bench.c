@@ -0,0 +1,103 @@
+#include "cutils.h"
+#include "bench.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define THREADS 8
+#define OPS_PER_THREAD 4000000
+// Objects each thread keeps live, freed in a shuffled order
+#define LIVE_PER_THREAD 256
+#define OBJECT_SIZE 48
+
+typedef struct {
+    Pool *pool;
+    uint64_t seed;
+    uint64_t checksum;
+} Worker;
+
+static void *pool_churn(Worker *w)
+{
+    void *live[LIVE_PER_THREAD] = {0};
+    uint64_t state = w->seed;
+    for (size_t i = 0; i < OPS_PER_THREAD; ++i) {
+        size_t slot = bench_rand(&state) % LIVE_PER_THREAD;
+        if (live[slot]) {
+            w->checksum += *(uint64_t*)live[slot];
+            if (w->pool) pool_free(w->pool, live[slot]);
+            else free(live[slot]);
+        }
+        unsigned char *p = w->pool ? pool_alloc(w->pool) : malloc(OBJECT_SIZE);
+        // Write the whole object, the pool must not keep anything in it
+        memset(p, (int)(i & 0xff), OBJECT_SIZE);
+        *(uint64_t*)p = i;
+        live[slot] = p;
+    }
+    for (size_t i = 0; i < LIVE_PER_THREAD; ++i) {
+        if (!live[i]) continue;
+        if (w->pool) pool_free(w->pool, live[i]);
+        else free(live[i]);
+    }
+    if (w->pool) pool_flush_thread_cache(w->pool);
+    return NULL;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) { pool_churn(arg); return 0; }
+#else
+static void *worker_main(void *arg) { return pool_churn(arg); }
+#endif
+
+static double run_threads(Pool *pool, int threads)
+{
+    Worker workers[THREADS];
+#ifdef _WIN32
+    HANDLE handles[THREADS];
+#else
+    pthread_t handles[THREADS];
+#endif
+    double start = bench_now();
+    for (int i = 0; i < threads; ++i) {
+        workers[i] = (Worker){ .pool = pool, .seed = 0x9e3779b97f4a7c15ull*(i + 1) };
+#ifdef _WIN32
+        handles[i] = CreateThread(NULL, 0, worker_main, &workers[i], 0, NULL);
+#else
+        pthread_create(&handles[i], NULL, worker_main, &workers[i]);
+#endif
+    }
+    for (int i = 0; i < threads; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+#else
+        pthread_join(handles[i], NULL);
+#endif
+        bench_sink += workers[i].checksum;
+    }
+    return bench_now() - start;
+}
+
+// Alloc/write/free churn from 1 to THREADS threads against malloc/free.
+// Also the stress test for the lock-free paths, build it with
+// -fsanitize=thread to check them.
+int main(void)
+{
+    for (int threads = 1; threads <= THREADS; threads *= 2) {
+        char name[64];
+        Pool *pool = pool_create(OBJECT_SIZE, 0);
+        double elapsed = run_threads(pool, threads);
+        if (pool_get_stats(pool).live != 0) {
+            fprintf(stderr, "error: pool leaked %zu objects\n", pool_get_stats(pool).live);
+            return 1;
+        }
+        snprintf(name, sizeof(name), "pool %d threads", threads);
+        bench_report(name, elapsed, (double)OPS_PER_THREAD*threads, "ops");
+        pool_destroy(pool);
+
+        elapsed = run_threads(NULL, threads);
+        snprintf(name, sizeof(name), "malloc %d threads", threads);
+        bench_report(name, elapsed, (double)OPS_PER_THREAD*threads, "ops");
+    }
+    return 0;
+}
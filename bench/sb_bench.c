@@ -0,0 +1,44 @@
+#include "cutils.h"
+#include "bench.h"
+
+#define APPENDS 2000000
+
+// Each case appends APPENDS pieces into one builder that is reused across
+// cases, so after the first case growth no longer shows up in the timings
+#define BENCH_SB(name, sb, body)                                            \
+    do {                                                                    \
+        (sb)->count = 0;                                                    \
+        double bench__start = bench_now();                                  \
+        for (size_t i = 0; i < APPENDS; ++i) { body; }                      \
+        bench__start = bench_now() - bench__start;                          \
+        bench_sink += (sb)->count;                                          \
+        bench_report((name), bench__start, APPENDS, "appends");             \
+    } while (0)
+
+int main(void)
+{
+    StringBuilder sb = {0};
+    BENCH_SB("sb_append_char", &sb, sb_append_char(&sb, 'a' + (char)(i & 15)));
+    BENCH_SB("sb_append_cstr", &sb, sb_append_cstr(&sb, "vertex"));
+    BENCH_SB("sb_append_buf 16 B", &sb, sb_append_buf(&sb, "0123456789abcdef", 16));
+    BENCH_SB("sb_append_int", &sb, sb_append_int(&sb, (int64_t)i - APPENDS/2));
+    BENCH_SB("sb_appendf %d", &sb, sb_appendf(&sb, "%d", (int)i - APPENDS/2));
+    BENCH_SB("sb_append_uint", &sb, sb_append_uint(&sb, i*2654435761u));
+    BENCH_SB("sb_appendf %llu", &sb, sb_appendf(&sb, "%llu", (unsigned long long)(i*2654435761u)));
+    BENCH_SB("sb_append_float", &sb, sb_append_float(&sb, (double)i*0.001, 3));
+    BENCH_SB("sb_appendf %.3f", &sb, sb_appendf(&sb, "%.3f", (double)i*0.001));
+    BENCH_SB("sb_appendf v %f %f %f", &sb, sb_appendf(&sb, "v %f %f %f\n", (double)i, 0.5, -(double)i));
+    sb_free(&sb);
+
+    // Growing from empty every time exercises the sb_appendf path that
+    // overflows the spare capacity and formats a second time
+    double start = bench_now();
+    for (size_t round = 0; round < APPENDS/1000; ++round) {
+        StringBuilder fresh = {0};
+        for (size_t i = 0; i < 1000; ++i) sb_appendf(&fresh, "%zu,%zu;", round, i);
+        bench_sink += fresh.count;
+        sb_free(&fresh);
+    }
+    bench_report("sb_appendf growing", bench_now() - start, APPENDS, "appends");
+    return 0;
+}
@@ -0,0 +1,69 @@
+#define GM_IMPLEMENTATION
+#include "gm.h"
+#include "bench.h"
+
+#define COUNT 1024
+#define ROUNDS 5000
+
+static Mat4 inputs[COUNT];
+static Mat4 outputs[COUNT];
+static Affine3 affine_inputs[COUNT];
+static Affine3 affine_outputs[COUNT];
+static float angles[COUNT];
+
+// The full product the in-place helpers replace, with the operand built
+// the way mat4_translate used to build it
+static Mat4 translate_by_dot(Mat4 a, Vec3 v)
+{
+    Mat4 t = mat4_eye(1.0f);
+    t.data[3] = v.x;
+    t.data[7] = v.y;
+    t.data[11] = v.z;
+    return mat4_dot(a, t);
+}
+
+static Mat4 rotate_y_by_dot(Mat4 a, float angle_radians)
+{
+    Mat4 r = mat4_eye(1.0f);
+    float s = sinf(angle_radians);
+    float c = cosf(angle_radians);
+    r.data[0] = c;
+    r.data[2] = s;
+    r.data[8] = -s;
+    r.data[10] = c;
+    return mat4_dot(a, r);
+}
+
+#define BENCH_LOOP(name, body)                                              \
+    do {                                                                    \
+        double bench__start = bench_now();                                  \
+        for(size_t round = 0; round < ROUNDS; ++round) {                    \
+            for(size_t i = 0; i < COUNT; ++i) { body; }                     \
+        }                                                                   \
+        bench_report((name), bench_now() - bench__start, (double)COUNT*ROUNDS, "ops"); \
+    } while(0)
+
+int main(void)
+{
+    uint64_t state = 3;
+    for(size_t i = 0; i < COUNT; ++i) {
+        for(int j = 0; j < 12; ++j) inputs[i].data[j] = bench_randf(&state, -2.0f, 2.0f);
+        inputs[i].data[12] = inputs[i].data[13] = inputs[i].data[14] = 0.0f;
+        inputs[i].data[15] = 1.0f;
+        affine_inputs[i] = affine3_from_mat4(inputs[i]);
+        angles[i] = bench_randf(&state, -PI, PI);
+    }
+    Vec3 v = vec3(1.0f, 2.0f, 3.0f);
+
+    BENCH_LOOP("translate via mat4_dot", outputs[i] = translate_by_dot(inputs[i], v));
+    BENCH_LOOP("mat4_translate in place", outputs[i] = mat4_translate(inputs[i], v));
+    BENCH_LOOP("affine3_translate", affine_outputs[i] = affine3_translate(affine_inputs[i], v));
+    BENCH_LOOP("rotate_y via mat4_dot", outputs[i] = rotate_y_by_dot(inputs[i], angles[i]));
+    BENCH_LOOP("mat4_rotate_y in place", outputs[i] = mat4_rotate_y(inputs[i], angles[i]));
+    BENCH_LOOP("affine3_rotate_y", affine_outputs[i] = affine3_rotate_y(affine_inputs[i], angles[i]));
+    BENCH_LOOP("compose mat4_dot", outputs[i] = mat4_dot(inputs[i], inputs[(i + 1) % COUNT]));
+    BENCH_LOOP("compose affine3_dot", affine_outputs[i] = affine3_dot(affine_inputs[i], affine_inputs[(i + 1) % COUNT]));
+
+    bench_sink += (uint64_t)outputs[COUNT/2].data[3] + (uint64_t)affine_outputs[COUNT/2].data[3];
+    return 0;
+}
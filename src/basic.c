@@ -144,7 +144,7 @@ int main(void)
     };
     glEnable(GL_DEPTH_TEST);
 
-    Renderer *ren = render_init();
+    Renderer *ren = render_init(NULL);
 
     GLuint vbo = 0;
     glGenBuffers(1, &vbo);
@@ -229,8 +229,8 @@ int main(void)
         glfwPollEvents();
     }
 
-    da_free(&vert);
-    da_free(&frag);
+    sb_free(&vert);
+    sb_free(&frag);
     render_close(ren);
     glfwTerminate();
     return 0;
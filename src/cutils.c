@@ -1,5 +1,18 @@
 #include "cutils.h"
 #include <stdarg.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 #ifdef NDEBUG
 #define DEBUGLOG(...)
@@ -7,14 +20,106 @@
 #define DEBUGLOG(...) fprintf(stderr, __VA_ARGS__)
 #endif
 
+size_t da_grow_capacity(size_t capacity, size_t required_cap, size_t init_cap, float growth)
+{
+    if (capacity == 0) capacity = init_cap > 0 ? init_cap : 1;
+    if (growth <= 1.0f) return capacity < required_cap ? required_cap : capacity;
+    while (capacity < required_cap) {
+        size_t next = (size_t)(capacity*growth);
+        if (next <= capacity) return required_cap;
+        capacity = next;
+    }
+    return capacity;
+}
+
+void *allocator_alloc(Allocator *allocator, size_t size)
+{
+    return allocator_realloc(allocator, NULL, 0, size);
+}
+
+void *allocator_realloc(Allocator *allocator, void *ptr, size_t old_size, size_t new_size)
+{
+    if (allocator) return allocator->proc(allocator, ptr, old_size, new_size);
+    if (new_size == 0) {
+        CUT_FREE(ptr);
+        return NULL;
+    }
+    if (ptr == NULL) return CUT_MALLOC(new_size);
+    return CUT_REALLOC(ptr, old_size, new_size);
+}
+
+void allocator_free(Allocator *allocator, void *ptr, size_t size)
+{
+    if (ptr) allocator_realloc(allocator, ptr, size, 0);
+}
+
+static TrackingAllocator *tracking__list = NULL;
+
+static void *tracking__proc(Allocator *allocator, void *ptr, size_t old_size, size_t new_size)
+{
+    TrackingAllocator *t = (TrackingAllocator*)allocator;
+    if (ptr == NULL) old_size = 0;
+    void *result = allocator_realloc(t->backing, ptr, old_size, new_size);
+    if (new_size > 0 && result == NULL) return NULL;
+
+    if (ptr == NULL && new_size > 0) t->allocations++;
+    if (ptr != NULL && new_size == 0) t->frees++;
+    t->bytes = t->bytes - old_size + new_size;
+    if (t->bytes > t->peak_bytes) t->peak_bytes = t->bytes;
+    return result;
+}
+
+Allocator *tracking_allocator_init(TrackingAllocator *t, const char *tag, Allocator *backing)
+{
+    memset(t, 0, sizeof(*t));
+    t->allocator.proc = tracking__proc;
+    t->backing = backing;
+    t->tag = tag;
+    t->next = tracking__list;
+    tracking__list = t;
+    return &t->allocator;
+}
+
+void tracking_allocator_deinit(TrackingAllocator *t)
+{
+    for (TrackingAllocator **it = &tracking__list; *it != NULL; it = &(*it)->next) {
+        if (*it == t) {
+            *it = t->next;
+            break;
+        }
+    }
+}
+
+void tracking_allocator_report(FILE *stream)
+{
+    fprintf(stream, "%-16s %12s %12s %10s %10s\n", "tag", "bytes", "peak", "allocs", "frees");
+    for (TrackingAllocator *t = tracking__list; t != NULL; t = t->next) {
+        fprintf(stream, "%-16s %12zu %12zu %10zu %10zu\n",
+                t->tag, t->bytes, t->peak_bytes, t->allocations, t->frees);
+    }
+}
+
+void sb_free(StringBuilder *sb)
+{
+    allocator_da_free(sb->allocator, sb);
+}
+
 int sb_appendf(StringBuilder *sb, const char *fmt, ...)
 {
     va_list args;
+    // Most appends fit the spare capacity, so format straight into it. The
+    // first call also reports the full length, so a miss formats only once more
+    size_t spare = sb->capacity - sb->count;
     va_start(args, fmt);
-    int n = vsnprintf(NULL, 0, fmt, args);
+    int n = vsnprintf(spare > 0 ? sb->items + sb->count : NULL, spare, fmt, args);
     va_end(args);
+    if (n < 0) return n;
+    if ((size_t)n < spare) {
+        sb->count += n;
+        return n;
+    }
 
-    da_reserve(sb, sb->count + n + 1);
+    allocator_da_reserve(sb->allocator, sb, sb->count + n + 1);
     char *dst = sb->items + sb->count;
     va_start(args, fmt);
     vsnprintf(dst, n+1, fmt, args);
@@ -23,6 +128,117 @@ int sb_appendf(StringBuilder *sb, const char *fmt, ...)
     return n;
 }
 
+void sb_append_buf(StringBuilder *sb, const void *buf, size_t size)
+{
+    allocator_da_reserve(sb->allocator, sb, sb->count + size + 1);
+    memcpy(sb->items + sb->count, buf, size);
+    sb->count += size;
+    sb->items[sb->count] = 0;
+}
+
+void sb_append_cstr(StringBuilder *sb, const char *cstr)
+{
+    sb_append_buf(sb, cstr, strlen(cstr));
+}
+
+void sb_append_char(StringBuilder *sb, char c)
+{
+    allocator_da_reserve(sb->allocator, sb, sb->count + 2);
+    sb->items[sb->count++] = c;
+    sb->items[sb->count] = 0;
+}
+
+void sb_append_uint(StringBuilder *sb, uint64_t value)
+{
+    char buf[20];
+    size_t i = sizeof(buf);
+    do {
+        buf[--i] = '0' + value%10;
+        value /= 10;
+    } while (value > 0);
+    sb_append_buf(sb, buf + i, sizeof(buf) - i);
+}
+
+void sb_append_int(StringBuilder *sb, int64_t value)
+{
+    if (value < 0) {
+        sb_append_char(sb, '-');
+        // Negate in unsigned space so INT64_MIN doesn't overflow
+        sb_append_uint(sb, 0 - (uint64_t)value);
+    } else {
+        sb_append_uint(sb, (uint64_t)value);
+    }
+}
+
+void sb_append_float(StringBuilder *sb, double value, int precision)
+{
+    if (precision < 0) precision = 0;
+    // Past these bounds the integer split below loses digits, let libc do it
+    if (precision > 9 || value != value || value > 1e18 || value < -1e18) {
+        sb_appendf(sb, "%.*f", precision, value);
+        return;
+    }
+
+    uint64_t scale = 1;
+    for (int i = 0; i < precision; ++i) scale *= 10;
+
+    if (value < 0) {
+        value = -value;
+        // Don't print "-0.00" for values that round to zero
+        if (value*scale >= 0.5) sb_append_char(sb, '-');
+    }
+    uint64_t whole = (uint64_t)value;
+    uint64_t frac  = (uint64_t)((value - (double)whole)*scale + 0.5);
+    if (frac >= scale) {
+        whole += 1;
+        frac  -= scale;
+    }
+    sb_append_uint(sb, whole);
+    if (precision == 0) return;
+
+    char buf[10];
+    buf[0] = '.';
+    for (int i = precision; i > 0; --i) {
+        buf[i] = '0' + frac%10;
+        frac /= 10;
+    }
+    sb_append_buf(sb, buf, precision + 1);
+}
+
+StringView sv_from_parts(const char *data, size_t count)
+{
+    StringView sv;
+    sv.data = data;
+    sv.count = count;
+    return sv;
+}
+
+StringView sv_from_cstr(const char *cstr)
+{
+    return sv_from_parts(cstr, strlen(cstr));
+}
+
+StringView sb_to_sv(StringBuilder sb)
+{
+    return sv_from_parts(sb.items, sb.count);
+}
+
+bool sv_eq(StringView a, StringView b)
+{
+    return a.count == b.count && (a.count == 0 || memcmp(a.data, b.data, a.count) == 0);
+}
+
+// 64-bit FNV-1a
+uint64_t sv_hash(StringView sv)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < sv.count; ++i) {
+        hash ^= (unsigned char)sv.data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
 bool read_entire_file(const char *filepath, StringBuilder *sb)
 {
     FILE *f = fopen(filepath, "rb");
@@ -47,7 +263,7 @@ bool read_entire_file(const char *filepath, StringBuilder *sb)
         return false;
     }
 
-    da_reserve(sb, sb->count + fsz + 1);
+    allocator_da_reserve(sb->allocator, sb, sb->count + fsz + 1);
     fread(sb->items + sb->count, fsz, 1, f);
     sb->items[sb->count + fsz] = 0;
     if (ferror(f)) {
@@ -84,56 +300,516 @@ bool write_entire_file(const char *filepath, const void *data, size_t size)
     return true;
 }
 
+bool write_entire_file_atomic(const char *filepath, const void *data, size_t size, FileDurability durability)
+{
+    FileChunk chunk = { .data = data, .size = size };
+    return write_entire_file_atomicv(filepath, &chunk, 1, durability);
+}
+
+#define ATOMIC_WRITE_MAX_ATTEMPTS 16
+
+static _Atomic uint32_t atomic_write__counter = 0;
+
+// `<filepath>.<pid>.<n>.tmp` in the target's directory, so overlapping saves
+// of one file from several threads or processes never share a temp file
+static void atomic_write__tmppath(char *tmppath, size_t size, const char *filepath)
+{
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    snprintf(tmppath, size, "%s.%lu.%u.tmp", filepath, pid, (unsigned)atomic_fetch_add(&atomic_write__counter, 1));
+}
+
+#ifdef _WIN32
+static bool write_chunks__platform(char *tmppath, size_t tmppath_size, bool *created, const char *filepath, const FileChunk *chunks, size_t count, FileDurability durability)
+{
+    // Keep the attributes of the file being replaced, except read-only
+    // which would make the replacement fail
+    DWORD attributes = GetFileAttributesA(filepath);
+    if (attributes == INVALID_FILE_ATTRIBUTES) attributes = FILE_ATTRIBUTE_NORMAL;
+    attributes &= ~(DWORD)(FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_DIRECTORY);
+    if (attributes == 0) attributes = FILE_ATTRIBUTE_NORMAL;
+
+    HANDLE h = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < ATOMIC_WRITE_MAX_ATTEMPTS && h == INVALID_HANDLE_VALUE; ++attempt) {
+        // Stale temp files of a dead process with the same pid are skipped
+        atomic_write__tmppath(tmppath, tmppath_size, filepath);
+        h = CreateFileA(tmppath, GENERIC_WRITE, 0, NULL, CREATE_NEW,
+                attributes | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (h == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS) break;
+    }
+    if (h == INVALID_HANDLE_VALUE) {
+        DEBUGLOG("error: Could not open a file '%s'\n", tmppath);
+        return false;
+    }
+    *created = true;
+    for (size_t i = 0; i < count; ++i) {
+        const char *buf = chunks[i].data;
+        size_t size = chunks[i].size;
+        while (size > 0) {
+            DWORD n = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+            DWORD written = 0;
+            if (!WriteFile(h, buf, n, &written, NULL)) {
+                DEBUGLOG("error: Could not write into file '%s'\n", tmppath);
+                CloseHandle(h);
+                return false;
+            }
+            size -= written;
+            buf  += written;
+        }
+    }
+    if (durability == FILE_DURABILITY_SYNC && !FlushFileBuffers(h)) {
+        DEBUGLOG("error: Could not flush file '%s'\n", tmppath);
+        CloseHandle(h);
+        return false;
+    }
+    CloseHandle(h);
+
+    DWORD flags = MOVEFILE_REPLACE_EXISTING;
+    if (durability == FILE_DURABILITY_SYNC) flags |= MOVEFILE_WRITE_THROUGH;
+    if (!MoveFileExA(tmppath, filepath, flags)) {
+        DEBUGLOG("error: Could not rename '%s' to '%s'\n", tmppath, filepath);
+        return false;
+    }
+    return true;
+}
+#else
+static bool write_chunks__platform(char *tmppath, size_t tmppath_size, bool *created, const char *filepath, const FileChunk *chunks, size_t count, FileDurability durability)
+{
+    // Like mkstemp, but a new file still gets 0666 minus the umask
+    int fd = -1;
+    for (int attempt = 0; attempt < ATOMIC_WRITE_MAX_ATTEMPTS && fd < 0; ++attempt) {
+        // Stale temp files of a dead process with the same pid are skipped
+        atomic_write__tmppath(tmppath, tmppath_size, filepath);
+        fd = open(tmppath, O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd < 0 && errno != EEXIST) break;
+    }
+    if (fd < 0) {
+        DEBUGLOG("error: Could not open a file '%s': %s\n", tmppath, strerror(errno));
+        return false;
+    }
+    *created = true;
+
+    // The replacement keeps the permissions of the file it replaces
+    struct stat st;
+    if (stat(filepath, &st) == 0 && fchmod(fd, st.st_mode & 07777) < 0) {
+        DEBUGLOG("error: Could not copy the mode of '%s': %s\n", filepath, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    // writev hands every chunk to the kernel in one call, nothing is copied
+    // through a user-space buffer. Partial writes resume mid-chunk.
+    struct iovec iov[64];
+    size_t chunk = 0, chunk_offset = 0;
+    while (chunk < count) {
+        int iovcnt = 0;
+        for (size_t i = chunk; i < count && iovcnt < (int)ARRAY_LEN(iov); ++i) {
+            size_t skip = i == chunk ? chunk_offset : 0;
+            iov[iovcnt].iov_base = (char*)chunks[i].data + skip;
+            iov[iovcnt].iov_len  = chunks[i].size - skip;
+            iovcnt++;
+        }
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            DEBUGLOG("error: Could not write into file '%s': %s\n", tmppath, strerror(errno));
+            close(fd);
+            return false;
+        }
+        size_t written = (size_t)n;
+        while (chunk < count && written >= chunks[chunk].size - chunk_offset) {
+            written -= chunks[chunk].size - chunk_offset;
+            chunk_offset = 0;
+            chunk++;
+        }
+        chunk_offset += written;
+    }
+
+    if (durability == FILE_DURABILITY_SYNC) {
+#if defined(__APPLE__)
+        int rc = fsync(fd);
+#else
+        int rc = fdatasync(fd);
+#endif
+        if (rc < 0) {
+            DEBUGLOG("error: Could not sync file '%s': %s\n", tmppath, strerror(errno));
+            close(fd);
+            return false;
+        }
+    }
+    if (close(fd) < 0) {
+        DEBUGLOG("error: Could not close file '%s': %s\n", tmppath, strerror(errno));
+        return false;
+    }
+
+    if (rename(tmppath, filepath) < 0) {
+        DEBUGLOG("error: Could not rename '%s' to '%s': %s\n", tmppath, filepath, strerror(errno));
+        return false;
+    }
+
+    if (durability == FILE_DURABILITY_SYNC) {
+        // Persist the directory entry too, otherwise the rename itself can
+        // be lost on power failure
+        const char *slash = strrchr(filepath, '/');
+        char *dirpath = slash ? strndup(filepath, slash == filepath ? 1 : (size_t)(slash - filepath)) : strdup(".");
+        int dfd = dirpath ? open(dirpath, O_RDONLY) : -1;
+        if (dfd >= 0) {
+            fsync(dfd);
+            close(dfd);
+        }
+        free(dirpath);
+    }
+    return true;
+}
+#endif
+
+bool write_entire_file_atomicv(const char *filepath, const FileChunk *chunks, size_t count, FileDurability durability)
+{
+    // Room for the `.<pid>.<n>.tmp` suffix
+    size_t tmppath_size = strlen(filepath) + 32;
+    char *tmppath = CUT_MALLOC(tmppath_size);
+    CUT_ASSERT(tmppath != NULL && "Buy More RAM LOL!");
+
+    bool created = false;
+    bool result = write_chunks__platform(tmppath, tmppath_size, &created, filepath, chunks, count, durability);
+    // Only remove a temp file this call created, the name may belong to
+    // another writer otherwise
+    if (!result && created) remove(tmppath);
+    CUT_FREE(tmppath);
+    return result;
+}
+
+static bool file_view__map(const char *filepath, FileView *view)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < 0) {
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        // Empty files can't be mapped but are still valid, empty views
+        CloseHandle(file);
+        view->data = "";
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return false;
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    // The view keeps the mapping alive
+    CloseHandle(mapping);
+    if (data == NULL) return false;
+    view->data = data;
+    view->size = (size_t)size.QuadPart;
+#else
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        // Empty files can't be mapped but are still valid, empty views
+        close(fd);
+        view->data = "";
+        return true;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    view->data = data;
+    view->size = (size_t)st.st_size;
+#endif
+    view->mapped = true;
+    return true;
+}
+
+bool file_view_open(const char *filepath, FileView *view)
+{
+    memset(view, 0, sizeof(*view));
+    if (file_view__map(filepath, view)) return true;
+
+    StringBuilder sb = {0};
+    if (!read_entire_file(filepath, &sb)) return false;
+    view->data = sb.items;
+    view->size = sb.count;
+    view->mapped = false;
+    return true;
+}
+
+void file_view_close(FileView *view)
+{
+    if (view->mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile((void*)view->data);
+#else
+        munmap((void*)view->data, view->size);
+#endif
+    } else if (view->size > 0) {
+        CUT_FREE((void*)view->data);
+    }
+    memset(view, 0, sizeof(*view));
+}
+
+bool file_reader_open(const char *filepath, FileReader *reader)
+{
+    memset(reader, 0, sizeof(*reader));
+#ifdef _WIN32
+    // 'S' asks the CRT for FILE_FLAG_SEQUENTIAL_SCAN
+    FILE *f = fopen(filepath, "rbS");
+#else
+    FILE *f = fopen(filepath, "rb");
+#endif
+    if (!f) {
+        DEBUGLOG("error: Could not open a file '%s'\n", filepath);
+        return false;
+    }
+    // Reads land directly in the caller's buffer, no stdio copy in between
+    setvbuf(f, NULL, _IONBF, 0);
+
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long fsz = ftell(f);
+        if (fsz > 0) reader->size = (size_t)fsz;
+    }
+    if (fseek(f, 0, SEEK_SET) < 0) {
+        DEBUGLOG("error: Could not seek into file '%s'\n", filepath);
+        fclose(f);
+        return false;
+    }
+
+    reader->f = f;
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fileno(f), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+bool file_reader_read(FileReader *reader, void *buffer, size_t capacity, size_t *nread)
+{
+    size_t n = fread(buffer, 1, capacity, reader->f);
+    reader->offset += n;
+    if (nread) *nread = n;
+    if (n < capacity && ferror(reader->f)) {
+        DEBUGLOG("error: Could not read from file: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void file_reader_readahead(FileReader *reader, size_t offset, size_t length)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fileno(reader->f), (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+#else
+    UNUSED(reader);
+    UNUSED(offset);
+    UNUSED(length);
+#endif
+}
+
+void file_reader_close(FileReader *reader)
+{
+    if (reader->f) fclose(reader->f);
+    memset(reader, 0, sizeof(*reader));
+}
 
 #define HEAP_PAGE_SIZE 4096
-void *arena_alloc(Arena *a, size_t bytesize)
+#ifndef ARENA_REGION_MAX_CAPACITY
+#define ARENA_REGION_MAX_CAPACITY (HEAP_PAGE_SIZE*256)
+#endif
+
+static ArenaRegion *arena__new_region(Arena *a, size_t capacity)
 {
-    size_t size = (bytesize + sizeof(uintptr_t) - 1)/sizeof(uintptr_t);
+    size_t allocated_bytes = sizeof(ArenaRegion) + sizeof(uintptr_t) * capacity;
+    ArenaRegion *r = (ArenaRegion*)allocator_alloc(a->allocator, allocated_bytes);
+    assert(r != NULL);
+    r->next = NULL;
+    r->count = 0;
+    r->capacity = capacity;
+    return r;
+}
+
+static void arena__free_region(Arena *a, ArenaRegion *r)
+{
+    allocator_free(a->allocator, r, sizeof(ArenaRegion) + sizeof(uintptr_t) * r->capacity);
+}
 
+// Regions after `a->end` are left over from an earlier rewind and only get
+// their count cleared once the arena moves onto them.
+static void arena__advance(Arena *a, ArenaRegion *target)
+{
+    while (a->end != target) {
+        a->end = a->end->next;
+        a->end->count = 0;
+    }
+}
+
+// Returns a region with room for `size` more words. Regions grow
+// geometrically up to ARENA_REGION_MAX_CAPACITY, and requests that would not
+// even fit the next region get a dedicated one on `a->large` so the tail of
+// the current region stays usable.
+static ArenaRegion *arena__region_for(Arena *a, size_t size)
+{
     if (a->end == NULL) {
         assert(a->begin == NULL);
         size_t capacity = HEAP_PAGE_SIZE;
         if (capacity < size) capacity = size;
-        size_t allocated_bytes = sizeof(ArenaRegion) + sizeof(uintptr_t) * capacity;
+        a->begin = arena__new_region(a, capacity);
+        a->end = a->begin;
+        return a->end;
+    }
+
+    if (a->end->count + size <= a->end->capacity) return a->end;
 
-        ArenaRegion *r = (ArenaRegion*)malloc(allocated_bytes);
-        assert(r != NULL);
-        r->next = NULL;
-        r->count = 0;
-        r->capacity = capacity;
-        a->end = r;
-        a->begin = r;
+    ArenaRegion *last = a->end;
+    for (ArenaRegion *r = a->end->next; r != NULL; r = r->next) {
+        if (size <= r->capacity) {
+            arena__advance(a, r);
+            return r;
+        }
+        last = r;
     }
 
-    while (a->end->count + size > a->end->capacity && a->end->next != NULL) {
-        a->end = a->end->next;
+    size_t capacity = last->capacity*2;
+    if (capacity > ARENA_REGION_MAX_CAPACITY) capacity = ARENA_REGION_MAX_CAPACITY;
+    if (capacity < HEAP_PAGE_SIZE) capacity = HEAP_PAGE_SIZE;
+
+    if (size > capacity) {
+        ArenaRegion *r = arena__new_region(a, size);
+        r->next = a->large;
+        a->large = r;
+        return r;
     }
 
-    if (a->end->count + size > a->end->capacity) {
-        assert(a->end->next == NULL);
-        size_t capacity = HEAP_PAGE_SIZE;
-        if (capacity < size) capacity = size;
+    arena__advance(a, last);
+    last->next = arena__new_region(a, capacity);
+    a->end = last->next;
+    return a->end;
+}
 
-        size_t allocated_bytes = sizeof(ArenaRegion) + sizeof(uintptr_t) * capacity;
-        ArenaRegion *r = (ArenaRegion*)malloc(allocated_bytes);
-        assert(r != NULL);
-        r->next = NULL;
-        r->count = 0;
-        r->capacity = capacity;
-        a->end->next = r;
-        a->end = a->end->next;
+void *arena_alloc(Arena *a, size_t bytesize)
+{
+    return arena_alloc_aligned(a, bytesize, sizeof(uintptr_t));
+}
+
+void *arena_alloc_aligned(Arena *a, size_t bytesize, size_t alignment)
+{
+    CUT_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+    if (alignment < sizeof(uintptr_t)) alignment = sizeof(uintptr_t);
+
+    size_t size = (bytesize + sizeof(uintptr_t) - 1)/sizeof(uintptr_t);
+    size_t max_padding = alignment/sizeof(uintptr_t) - 1;
+
+    ArenaRegion *r = a->end;
+    size_t padding = 0;
+    if (r != NULL) {
+        uintptr_t addr = (uintptr_t)&r->data[r->count];
+        padding = ((alignment - (addr & (alignment - 1))) & (alignment - 1))/sizeof(uintptr_t);
     }
+    if (r == NULL || r->count + padding + size > r->capacity) {
+        r = arena__region_for(a, size + max_padding);
+        uintptr_t addr = (uintptr_t)&r->data[r->count];
+        padding = ((alignment - (addr & (alignment - 1))) & (alignment - 1))/sizeof(uintptr_t);
+    }
+
+    void *result = &r->data[r->count + padding];
+    r->count += padding + size;
+    return result;
+}
 
-    void *result = &a->end->data[a->end->count];
-    a->end->count += size;
+void *arena_alloc_zero(Arena *a, size_t bytesize, size_t alignment)
+{
+    void *result = arena_alloc_aligned(a, bytesize, alignment);
+    memset(result, 0, bytesize);
+    return result;
+}
+
+// Grows or shrinks `old` in place when it is the last allocation of the
+// current region. Otherwise the data moves to a block reused from the free
+// list (or a fresh one) and the old block goes on the free list.
+void *arena_realloc(Arena *a, void *old, size_t old_bytesize, size_t new_bytesize)
+{
+    if (old == NULL) return arena_alloc(a, new_bytesize);
+
+    size_t old_size = (old_bytesize + sizeof(uintptr_t) - 1)/sizeof(uintptr_t);
+    size_t new_size = (new_bytesize + sizeof(uintptr_t) - 1)/sizeof(uintptr_t);
+
+    ArenaRegion *r = a->end;
+    bool is_last = r != NULL && (uintptr_t)old + old_size*sizeof(uintptr_t) == (uintptr_t)&r->data[r->count];
+    if (is_last && r->count - old_size + new_size <= r->capacity) {
+        r->count = r->count - old_size + new_size;
+        return old;
+    }
+    if (new_size <= old_size) return old;
+
+    if (is_last) {
+        // Give the space back first, the region can't hold the new size so
+        // the block below never overlaps it.
+        r->count -= old_size;
+        void *result = arena_alloc(a, new_bytesize);
+        memcpy(result, old, old_bytesize);
+        return result;
+    }
+
+    void *result = NULL;
+    for (ArenaFreeBlock **fb = &a->free; *fb != NULL; fb = &(*fb)->next) {
+        ArenaFreeBlock *block = *fb;
+        if (block->size < new_size) continue;
+        *fb = block->next;
+        // Only the bytes handed out stop being waste, the tail stays wasted
+        // whether or not it is big enough to go back on the free list
+        a->wasted -= new_size;
+        size_t rest = block->size - new_size;
+        if (rest*sizeof(uintptr_t) >= sizeof(ArenaFreeBlock)) {
+            ArenaFreeBlock *tail = (ArenaFreeBlock*)((uintptr_t*)block + new_size);
+            tail->size = rest;
+            tail->next = a->free;
+            a->free = tail;
+        }
+        result = block;
+        break;
+    }
+    if (result == NULL) result = arena_alloc(a, new_bytesize);
+    memcpy(result, old, old_bytesize);
+
+    a->wasted += old_size;
+    if (old_size*sizeof(uintptr_t) >= sizeof(ArenaFreeBlock)) {
+        ArenaFreeBlock *block = old;
+        block->size = old_size;
+        block->next = a->free;
+        a->free = block;
+    }
     return result;
 }
 
 void arena_reset(Arena *a)
 {
-    for (ArenaRegion *r = a->begin; r != NULL; r = r->next) {
-        r->count = 0;
+    a->free = NULL;
+    a->wasted = 0;
+    if (a->begin == NULL) return;
+
+    if (a->begin->next != NULL || a->large != NULL) {
+        // The last cycle outgrew the first region. Fold everything into a
+        // single region sized to the high-water mark so the following cycles
+        // are served by pointer bumps alone.
+        size_t capacity = 0;
+        for (ArenaRegion *r = a->begin; r != NULL; r = r->next) capacity += r->capacity;
+        for (ArenaRegion *r = a->large; r != NULL; r = r->next) capacity += r->capacity;
+        arena_free(a);
+        a->begin = arena__new_region(a, capacity);
+        a->end = a->begin;
+        return;
     }
+
+    a->begin->count = 0;
     a->end = a->begin;
 }
 
@@ -143,10 +819,111 @@ void arena_free(Arena *a)
     while (r) {
         ArenaRegion *r0 = r;
         r = r->next;
-        free(r0);
+        arena__free_region(a, r0);
+    }
+    r = a->large;
+    while (r) {
+        ArenaRegion *r0 = r;
+        r = r->next;
+        arena__free_region(a, r0);
     }
     a->begin = NULL;
     a->end = NULL;
+    a->large = NULL;
+    a->free = NULL;
+    a->wasted = 0;
+}
+
+ArenaMark arena_snapshot(Arena *a)
+{
+    ArenaMark mark = {0};
+    mark.region = a->end;
+    mark.count  = a->end ? a->end->count : 0;
+    mark.large  = a->large;
+    mark.wasted = a->wasted;
+    return mark;
+}
+
+void arena_rewind(Arena *a, ArenaMark mark)
+{
+    // Blocks freed after the mark may live in memory we are about to
+    // release and older ones may have been handed out again, so drop the
+    // whole free list.
+    a->free = NULL;
+    a->wasted = mark.wasted;
+
+    while (a->large != mark.large) {
+        ArenaRegion *r = a->large;
+        a->large = r->next;
+        arena__free_region(a, r);
+    }
+
+    if (mark.region == NULL) {
+        if (a->begin != NULL) a->begin->count = 0;
+        a->end = a->begin;
+        return;
+    }
+
+    a->end = mark.region;
+    a->end->count = mark.count;
+}
+
+ArenaTemp arena_temp_begin(Arena *a)
+{
+    ArenaTemp temp;
+    temp.arena = a;
+    temp.mark  = arena_snapshot(a);
+    return temp;
+}
+
+void arena_temp_end(ArenaTemp temp)
+{
+    arena_rewind(temp.arena, temp.mark);
+}
+
+typedef struct FrameArenas {
+    Arena arenas[2];
+    uint64_t frame;
+} FrameArenas;
+
+static _Atomic uint64_t frame__index = 0;
+static _Thread_local FrameArenas frame__arenas;
+
+static FrameArenas *frame__sync(uint64_t frame)
+{
+    FrameArenas *fa = &frame__arenas;
+    if (fa->frame != frame) {
+        // The thread skipped frames, so the other arena is older than the
+        // previous frame as well
+        if (frame - fa->frame > 1) arena_reset(&fa->arenas[(frame + 1)&1]);
+        arena_reset(&fa->arenas[frame&1]);
+        fa->frame = frame;
+    }
+    return fa;
+}
+
+void frame_arena_begin(void)
+{
+    uint64_t frame = atomic_fetch_add_explicit(&frame__index, 1, memory_order_acq_rel) + 1;
+    frame__sync(frame);
+}
+
+Arena *frame_arena(void)
+{
+    uint64_t frame = atomic_load_explicit(&frame__index, memory_order_acquire);
+    return &frame__sync(frame)->arenas[frame&1];
+}
+
+Arena *frame_arena_previous(void)
+{
+    uint64_t frame = atomic_load_explicit(&frame__index, memory_order_acquire);
+    return &frame__sync(frame)->arenas[(frame + 1)&1];
+}
+
+void frame_arena_thread_free(void)
+{
+    arena_free(&frame__arenas.arenas[0]);
+    arena_free(&frame__arenas.arenas[1]);
 }
 
 char *arena_strndup(Arena *a, const char *cstr, size_t cstrlen)
@@ -177,11 +954,344 @@ char *arena_sprintf(Arena *a, const char *fmt, ...)
     return dst;
 }
 
-size_t arena_get_usage(Arena *a)
+ArenaUsage arena_get_usage(Arena *a)
 {
-    size_t result = 0;
+    ArenaUsage result = {0};
+    bool past_end = a->end == NULL;
     for (ArenaRegion *r = a->begin; r != NULL; r = r->next) {
-        result += r->count;
+        if (!past_end) result.used += r->count;
+        result.capacity += r->capacity;
+        if (r == a->end) past_end = true;
+    }
+    for (ArenaRegion *r = a->large; r != NULL; r = r->next) {
+        result.used += r->count;
+        result.capacity += r->capacity;
     }
+    result.wasted = a->wasted;
+
+    result.used     *= sizeof(uintptr_t);
+    result.capacity *= sizeof(uintptr_t);
+    result.wasted   *= sizeof(uintptr_t);
     return result;
 }
+
+// Linear probing over a power-of-two table of IDs kept at most half full.
+// Returns the slot holding `sv` or the empty slot where it belongs.
+static size_t interner__probe(StringInterner *si, StringView sv, uint64_t hash)
+{
+    size_t mask = si->slots_capacity - 1;
+    size_t i = (size_t)hash & mask;
+    for (;;) {
+        StringID id = si->slots[i];
+        if (id == INVALID_STRING_ID) return i;
+        InternedString *entry = &si->strings.items[id - 1];
+        if (entry->hash == hash && sv_eq(entry->sv, sv)) return i;
+        i = (i + 1) & mask;
+    }
+}
+
+static void interner__grow(StringInterner *si)
+{
+    size_t capacity = si->slots_capacity ? si->slots_capacity*2 : 64;
+    StringID *slots = allocator_alloc(si->arena.allocator, capacity*sizeof(*slots));
+    CUT_ASSERT(slots != NULL && "Buy More RAM LOL!");
+    memset(slots, 0, capacity*sizeof(*slots));
+
+    allocator_free(si->arena.allocator, si->slots, si->slots_capacity*sizeof(*slots));
+    si->slots = slots;
+    si->slots_capacity = capacity;
+    for (size_t i = 0; i < si->strings.count; ++i) {
+        InternedString *entry = &si->strings.items[i];
+        size_t slot = (size_t)entry->hash & (capacity - 1);
+        while (slots[slot] != INVALID_STRING_ID) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = (StringID)(i + 1);
+    }
+}
+
+StringID interner_find(StringInterner *si, StringView sv)
+{
+    if (si->slots_capacity == 0) return INVALID_STRING_ID;
+    return si->slots[interner__probe(si, sv, sv_hash(sv))];
+}
+
+StringID interner_intern(StringInterner *si, StringView sv)
+{
+    if ((si->strings.count + 1)*2 > si->slots_capacity) interner__grow(si);
+
+    uint64_t hash = sv_hash(sv);
+    size_t slot = interner__probe(si, sv, hash);
+    if (si->slots[slot] != INVALID_STRING_ID) return si->slots[slot];
+
+    InternedString entry;
+    entry.sv = sv_from_parts(arena_strndup(&si->arena, sv.data, sv.count), sv.count);
+    entry.hash = hash;
+    arena_da_append(&si->arena, &si->strings, entry);
+    si->slots[slot] = (StringID)si->strings.count;
+    return si->slots[slot];
+}
+
+StringID interner_intern_cstr(StringInterner *si, const char *cstr)
+{
+    return interner_intern(si, sv_from_cstr(cstr));
+}
+
+StringView interner_get(StringInterner *si, StringID id)
+{
+    CUT_ASSERT(id != INVALID_STRING_ID && id <= si->strings.count);
+    return si->strings.items[id - 1].sv;
+}
+
+uint64_t interner_get_hash(StringInterner *si, StringID id)
+{
+    CUT_ASSERT(id != INVALID_STRING_ID && id <= si->strings.count);
+    return si->strings.items[id - 1].hash;
+}
+
+void interner_free(StringInterner *si)
+{
+    Allocator *allocator = si->arena.allocator;
+    allocator_free(allocator, si->slots, si->slots_capacity*sizeof(*si->slots));
+    arena_free(&si->arena);
+    memset(si, 0, sizeof(*si));
+    si->arena.allocator = allocator;
+}
+
+#ifndef POOL_BLOCK_OBJECTS
+#define POOL_BLOCK_OBJECTS 1024
+#endif
+#ifndef POOL_MAX_BLOCKS
+#define POOL_MAX_BLOCKS 4096
+#endif
+#ifndef POOL_THREAD_CACHE_SIZE
+#define POOL_THREAD_CACHE_SIZE 64
+#endif
+#ifndef POOL_MAX_THREAD_CACHES
+#define POOL_MAX_THREAD_CACHES 8
+#endif
+#define POOL_CACHE_LINE 64
+
+// Every slot starts with a header of at least 8 bytes followed by the
+// object. The header holds the slot's own index in bytes 0..3 and, while the
+// slot is free, the next free index + 1 in bytes 4..7. The link lives out of
+// the object so a pop reading it never races a new owner writing the object.
+// The global free list head packs a tag in the high 32 bits and the top
+// index + 1 in the low ones; bumping the tag on every update defeats ABA.
+// The pool lives on its own cache lines so the head and the counters don't
+// false share, see pool_create for how that alignment is obtained.
+struct Pool {
+    _Alignas(POOL_CACHE_LINE) _Atomic uint64_t free_head;
+    _Alignas(POOL_CACHE_LINE) _Atomic size_t live;
+    _Atomic size_t peak;
+    _Atomic uint32_t next_index;
+    _Atomic uint32_t blocks_count;
+    uint32_t id;
+    size_t object_size;
+    size_t header;
+    size_t stride;
+    void *memory;
+    _Atomic(unsigned char*) blocks[POOL_MAX_BLOCKS];
+};
+
+typedef struct PoolThreadCache {
+    Pool *pool;
+    uint32_t pool_id;
+    uint32_t count;
+    uint32_t items[POOL_THREAD_CACHE_SIZE];
+} PoolThreadCache;
+
+static _Atomic uint32_t pool__next_id = 1;
+static _Thread_local PoolThreadCache pool__caches[POOL_MAX_THREAD_CACHES];
+
+Pool *pool_create(size_t object_size, size_t alignment)
+{
+    if (alignment < sizeof(uint64_t)) alignment = sizeof(uint64_t);
+    CUT_ASSERT((alignment & (alignment - 1)) == 0 && alignment <= _Alignof(max_align_t));
+
+    // CUT_MALLOC only promises max_align_t, over-allocate and align by hand
+    void *memory = CUT_MALLOC(sizeof(Pool) + POOL_CACHE_LINE - 1);
+    CUT_ASSERT(memory != NULL && "Buy More RAM LOL!");
+    Pool *pool = (Pool*)(((uintptr_t)memory + POOL_CACHE_LINE - 1) & ~(uintptr_t)(POOL_CACHE_LINE - 1));
+    memset(pool, 0, sizeof(*pool));
+    pool->memory = memory;
+    pool->id = atomic_fetch_add(&pool__next_id, 1);
+    pool->object_size = object_size;
+    pool->header = alignment;
+    pool->stride = alignment + ((object_size + alignment - 1) & ~(alignment - 1));
+    return pool;
+}
+
+void pool_destroy(Pool *pool)
+{
+    if (!pool) return;
+    for (size_t i = 0; i < POOL_MAX_THREAD_CACHES; ++i) {
+        if (pool__caches[i].pool == pool) memset(&pool__caches[i], 0, sizeof(pool__caches[i]));
+    }
+    for (size_t i = 0; i < POOL_MAX_BLOCKS; ++i) {
+        CUT_FREE(atomic_load(&pool->blocks[i]));
+    }
+    CUT_FREE(pool->memory);
+}
+
+static unsigned char *pool__slot(Pool *pool, uint32_t index)
+{
+    unsigned char *block = atomic_load_explicit(&pool->blocks[index/POOL_BLOCK_OBJECTS], memory_order_acquire);
+    return block + (index%POOL_BLOCK_OBJECTS)*pool->stride;
+}
+
+static _Atomic uint32_t *pool__next_link(Pool *pool, uint32_t index)
+{
+    return (_Atomic uint32_t*)(pool__slot(pool, index) + sizeof(uint32_t));
+}
+
+// The link read here may be stale if the slot was popped and pushed again
+// in the meantime, the tag check makes this pop fail whatever it read.
+static bool pool__pop(Pool *pool, uint32_t *index)
+{
+    uint64_t head = atomic_load_explicit(&pool->free_head, memory_order_acquire);
+    for (;;) {
+        uint32_t top = (uint32_t)head;
+        if (top == 0) return false;
+        uint32_t next = atomic_load_explicit(pool__next_link(pool, top - 1), memory_order_relaxed);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+        if (atomic_compare_exchange_weak_explicit(&pool->free_head, &head, new_head,
+                    memory_order_acq_rel, memory_order_acquire)) {
+            *index = top - 1;
+            return true;
+        }
+    }
+}
+
+// Pushes items[0..count) as one chain with a single CAS
+static void pool__push_chain(Pool *pool, const uint32_t *items, size_t count)
+{
+    for (size_t i = 0; i + 1 < count; ++i) {
+        atomic_store_explicit(pool__next_link(pool, items[i]), items[i + 1] + 1, memory_order_relaxed);
+    }
+    _Atomic uint32_t *last = pool__next_link(pool, items[count - 1]);
+    uint64_t head = atomic_load_explicit(&pool->free_head, memory_order_relaxed);
+    for (;;) {
+        atomic_store_explicit(last, (uint32_t)head, memory_order_relaxed);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | (items[0] + 1);
+        if (atomic_compare_exchange_weak_explicit(&pool->free_head, &head, new_head,
+                    memory_order_release, memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+// Carves up to `count` never-used slots, allocating their blocks on demand.
+// Racing threads may both allocate a block, the CAS loser frees its copy.
+static size_t pool__carve(Pool *pool, uint32_t *items, size_t count)
+{
+    const uint32_t max_index = (uint32_t)POOL_BLOCK_OBJECTS*POOL_MAX_BLOCKS;
+    uint32_t start = atomic_fetch_add_explicit(&pool->next_index, (uint32_t)count, memory_order_relaxed);
+    if (start >= max_index) {
+        atomic_store_explicit(&pool->next_index, max_index, memory_order_relaxed);
+        return 0;
+    }
+    if (count > max_index - start) count = max_index - start;
+
+    for (uint32_t b = start/POOL_BLOCK_OBJECTS; b <= (start + count - 1)/POOL_BLOCK_OBJECTS; ++b) {
+        if (atomic_load_explicit(&pool->blocks[b], memory_order_acquire) != NULL) continue;
+        unsigned char *block = CUT_MALLOC(POOL_BLOCK_OBJECTS*pool->stride);
+        CUT_ASSERT(block != NULL && "Buy More RAM LOL!");
+        unsigned char *expected = NULL;
+        if (atomic_compare_exchange_strong_explicit(&pool->blocks[b], &expected, block,
+                    memory_order_acq_rel, memory_order_acquire)) {
+            atomic_fetch_add_explicit(&pool->blocks_count, 1, memory_order_relaxed);
+        } else {
+            CUT_FREE(block);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        items[i] = start + (uint32_t)i;
+        memcpy(pool__slot(pool, items[i]), &items[i], sizeof(items[i]));
+    }
+    return count;
+}
+
+static PoolThreadCache *pool__thread_cache(Pool *pool)
+{
+    PoolThreadCache *unused = NULL;
+    for (size_t i = 0; i < POOL_MAX_THREAD_CACHES; ++i) {
+        PoolThreadCache *cache = &pool__caches[i];
+        if (cache->pool == pool) {
+            if (cache->pool_id == pool->id) return cache;
+            // A destroyed pool used to live at this address
+            cache->count = 0;
+        }
+        if (cache->count == 0 && unused == NULL) unused = cache;
+    }
+    if (unused) {
+        unused->pool = pool;
+        unused->pool_id = pool->id;
+    }
+    return unused;
+}
+
+void *pool_alloc(Pool *pool)
+{
+    PoolThreadCache *cache = pool__thread_cache(pool);
+    uint32_t index;
+    if (cache && cache->count > 0) {
+        index = cache->items[--cache->count];
+    } else if (!pool__pop(pool, &index)) {
+        if (cache) {
+            size_t n = pool__carve(pool, cache->items, POOL_THREAD_CACHE_SIZE/2);
+            if (n == 0) return NULL;
+            cache->count = (uint32_t)n;
+            index = cache->items[--cache->count];
+        } else if (pool__carve(pool, &index, 1) == 0) {
+            return NULL;
+        }
+    }
+
+    size_t live = atomic_fetch_add_explicit(&pool->live, 1, memory_order_relaxed) + 1;
+    size_t peak = atomic_load_explicit(&pool->peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&pool->peak, &peak, live,
+                memory_order_relaxed, memory_order_relaxed));
+    return pool__slot(pool, index) + pool->header;
+}
+
+void pool_free(Pool *pool, void *ptr)
+{
+    if (!ptr) return;
+    uint32_t index;
+    memcpy(&index, (unsigned char*)ptr - pool->header, sizeof(index));
+    atomic_fetch_sub_explicit(&pool->live, 1, memory_order_relaxed);
+
+    PoolThreadCache *cache = pool__thread_cache(pool);
+    if (!cache) {
+        pool__push_chain(pool, &index, 1);
+        return;
+    }
+    if (cache->count == POOL_THREAD_CACHE_SIZE) {
+        // Spill the older half so the thread keeps its hot objects
+        pool__push_chain(pool, cache->items, POOL_THREAD_CACHE_SIZE/2);
+        memmove(cache->items, cache->items + POOL_THREAD_CACHE_SIZE/2,
+                (POOL_THREAD_CACHE_SIZE - POOL_THREAD_CACHE_SIZE/2)*sizeof(cache->items[0]));
+        cache->count -= POOL_THREAD_CACHE_SIZE/2;
+    }
+    cache->items[cache->count++] = index;
+}
+
+void pool_flush_thread_cache(Pool *pool)
+{
+    for (size_t i = 0; i < POOL_MAX_THREAD_CACHES; ++i) {
+        PoolThreadCache *cache = &pool__caches[i];
+        if (cache->pool != pool || cache->pool_id != pool->id) continue;
+        if (cache->count > 0) pool__push_chain(pool, cache->items, cache->count);
+        cache->count = 0;
+    }
+}
+
+PoolStats pool_get_stats(Pool *pool)
+{
+    PoolStats stats;
+    stats.live = atomic_load(&pool->live);
+    stats.peak = atomic_load(&pool->peak);
+    stats.high_water = atomic_load(&pool->next_index);
+    stats.capacity = (size_t)atomic_load(&pool->blocks_count)*POOL_BLOCK_OBJECTS;
+    return stats;
+}
@@ -16,6 +16,9 @@
 #ifndef DA_INIT_CAP
 #define DA_INIT_CAP 256
 #endif
+#ifndef DA_GROWTH_FACTOR
+#define DA_GROWTH_FACTOR 2.0f
+#endif
 
 #define shiftargs(argc, argv) (assert(argc > 0), (argc)--, *(argv)++)
 
@@ -23,10 +26,26 @@
 #include <stdlib.h>
 #define CUT_MALLOC malloc
 #define CUT_FREE   free
+#ifndef CUT_REALLOC
+#define CUT_REALLOC(ptr, old_size, new_size) ((void)(old_size), realloc((ptr), (new_size)))
+#endif
 #endif
 #if !defined(CUT_MALLOC) || !defined(CUT_FREE)
 #error "Please define both CUT_MALLOC and CUT_FREE macros"
 #endif
+#ifndef CUT_REALLOC
+// Custom CUT_MALLOC/CUT_FREE without a matching CUT_REALLOC
+static inline void *cut__realloc_fallback(void *ptr, size_t old_size, size_t new_size)
+{
+    void *result = CUT_MALLOC(new_size);
+    if(result && ptr) {
+        memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+        CUT_FREE(ptr);
+    }
+    return result;
+}
+#define CUT_REALLOC cut__realloc_fallback
+#endif
 #ifndef CUT_ASSERT
 #include <assert.h>
 #define CUT_ASSERT assert
@@ -36,23 +55,47 @@
 #define TODO(message) do { fprintf(stderr, "%s:%d: TODO: %s\n", __FILE__, __LINE__, message); abort(); } while(0)
 #define UNREACHABLE(message) do { fprintf(stderr, "%s:%d: UNREACHABLE: %s", __FILE__, __LINE__, (message)); abort(); } while(0)
 
-#define da_free(da) free((da)->items)
+// Capacity to grow a dynamic array to so it holds `required_cap` items.
+// Starts at `init_cap` and multiplies by `growth`; a growth of 1 or less, or
+// one that stalls, jumps straight to `required_cap`.
+size_t da_grow_capacity(size_t capacity, size_t required_cap, size_t init_cap, float growth);
 
-#define da_reserve(da, required_cap)                                \
-    do {                                                            \
-        size_t item_size = sizeof(*(da)->items);                    \
-        if(required_cap > (da)->capacity) {                         \
-            if((da)->capacity == 0) (da)->capacity = DA_INIT_CAP;   \
-            while((da)->capacity < required_cap)                    \
-                (da)->capacity *= 2;                                \
-            void *items = CUT_MALLOC((da)->capacity * item_size);   \
-            CUT_ASSERT(items != NULL && "Buy More RAM LOL!");       \
-            if((da)->items) {                                       \
-                memcpy(items, (da)->items, (da)->count*item_size);  \
-                CUT_FREE((da)->items);                              \
-            }                                                       \
-            (da)->items = items;                                    \
-        }                                                           \
+#define da_free(da) CUT_FREE((da)->items)
+
+#define da_reserve_ex(da, required_cap, init_cap, growth)                   \
+    do {                                                                    \
+        size_t item_size = sizeof(*(da)->items);                            \
+        if((required_cap) > (da)->capacity) {                               \
+            size_t old_capacity = (da)->capacity;                           \
+            (da)->capacity = da_grow_capacity((da)->capacity,               \
+                (required_cap), (init_cap), (growth));                      \
+            (da)->items = CUT_REALLOC((da)->items,                          \
+                old_capacity*item_size, (da)->capacity*item_size);          \
+            CUT_ASSERT((da)->items != NULL && "Buy More RAM LOL!");         \
+        }                                                                   \
+    } while(0)
+
+#define da_reserve(da, required_cap) \
+    da_reserve_ex((da), (required_cap), DA_INIT_CAP, DA_GROWTH_FACTOR)
+
+// Sets the capacity of an empty array to exactly `required_cap` so small
+// tables don't start at DA_INIT_CAP. Later appends grow by DA_GROWTH_FACTOR.
+#define da_reserve_exact(da, required_cap) \
+    da_reserve_ex((da), (required_cap), (required_cap), 1.0f)
+
+#define da_shrink_to_fit(da)                                                \
+    do {                                                                    \
+        size_t item_size = sizeof(*(da)->items);                            \
+        if((da)->count == 0) {                                              \
+            CUT_FREE((da)->items);                                          \
+            (da)->items = NULL;                                             \
+            (da)->capacity = 0;                                             \
+        } else if((da)->count < (da)->capacity) {                           \
+            (da)->items = CUT_REALLOC((da)->items,                          \
+                (da)->capacity*item_size, (da)->count*item_size);           \
+            CUT_ASSERT((da)->items != NULL && "Buy More RAM LOL!");         \
+            (da)->capacity = (da)->count;                                   \
+        }                                                                   \
     } while(0)
 
 #define da_append(da, item)                                         \
@@ -63,24 +106,197 @@
 
 #define da_append_many(da, new_items, new_items_count)              \
     do {                                                            \
-        da_reserve((da), (da)->count + new_items_count);            \
+        size_t da__n = (new_items_count);                           \
+        da_reserve((da), (da)->count + da__n);                      \
         memcpy((da)->items + (da)->count, (new_items),              \
-            (new_items_count)*item_size);                           \
-        (da)->count += (new_items_count);                           \
+            da__n*sizeof(*(da)->items));                            \
+        (da)->count += da__n;                                       \
+    } while(0)
+
+#define da_insert_many(da, index, new_items, new_items_count)       \
+    do {                                                            \
+        size_t da__i = (index);                                     \
+        size_t da__n = (new_items_count);                           \
+        CUT_ASSERT(da__i <= (da)->count);                           \
+        da_reserve((da), (da)->count + da__n);                      \
+        memmove((da)->items + da__i + da__n, (da)->items + da__i,   \
+            ((da)->count - da__i)*sizeof(*(da)->items));            \
+        memcpy((da)->items + da__i, (new_items),                    \
+            da__n*sizeof(*(da)->items));                            \
+        (da)->count += da__n;                                       \
+    } while(0)
+
+// O(1) removal that moves the last item into the hole, order is not kept
+#define da_remove_swap(da, index)                                   \
+    do {                                                            \
+        size_t da__i = (index);                                     \
+        CUT_ASSERT(da__i < (da)->count);                            \
+        (da)->items[da__i] = (da)->items[--(da)->count];            \
+    } while(0)
+
+// Grows the array by `n` uninitialized items to be written in place,
+// starting at (da)->items + (da)->count - n
+#define da_extend_uninit(da, n)                                     \
+    do {                                                            \
+        size_t da__n = (n);                                         \
+        da_reserve((da), (da)->count + da__n);                      \
+        (da)->count += da__n;                                       \
     } while(0)
 
+// Runtime allocator interface, so subsystems can be handed their own heap
+// and be accounted separately. A single entry point allocates when `ptr` is
+// NULL, frees when `new_size` is 0 and resizes otherwise. Passing a NULL
+// Allocator anywhere means CUT_MALLOC/CUT_REALLOC/CUT_FREE.
+typedef struct Allocator Allocator;
+struct Allocator {
+    void *(*proc)(Allocator *allocator, void *ptr, size_t old_size, size_t new_size);
+};
+
+void *allocator_alloc(Allocator *allocator, size_t size);
+void *allocator_realloc(Allocator *allocator, void *ptr, size_t old_size, size_t new_size);
+void  allocator_free(Allocator *allocator, void *ptr, size_t size);
+
+// Counts bytes and allocations going through it and forwards them to
+// `backing`. Every initialized tracker shows up in tracking_allocator_report.
+// Not thread-safe, give each thread its own tag.
+typedef struct TrackingAllocator TrackingAllocator;
+struct TrackingAllocator {
+    Allocator allocator;
+    Allocator *backing;
+    const char *tag;
+    size_t bytes;
+    size_t peak_bytes;
+    size_t allocations;
+    size_t frees;
+    TrackingAllocator *next;
+};
+
+Allocator *tracking_allocator_init(TrackingAllocator *t, const char *tag, Allocator *backing);
+void       tracking_allocator_deinit(TrackingAllocator *t);
+void       tracking_allocator_report(FILE *stream);
+
+#define allocator_da_reserve(allocator, da, required_cap)                   \
+    do {                                                                    \
+        size_t item_size = sizeof(*(da)->items);                            \
+        if((required_cap) > (da)->capacity) {                               \
+            size_t old_capacity = (da)->capacity;                           \
+            (da)->capacity = da_grow_capacity((da)->capacity,               \
+                (required_cap), DA_INIT_CAP, DA_GROWTH_FACTOR);             \
+            (da)->items = allocator_realloc((allocator), (da)->items,       \
+                old_capacity*item_size, (da)->capacity*item_size);          \
+            CUT_ASSERT((da)->items != NULL && "Buy More RAM LOL!");         \
+        }                                                                   \
+    } while(0)
+
+#define allocator_da_append(allocator, da, item)                    \
+    do {                                                            \
+        allocator_da_reserve((allocator), (da), (da)->count + 1);   \
+        (da)->items[(da)->count++] = (item);                        \
+    } while(0)
 
+#define allocator_da_append_many(allocator, da, new_items, new_items_count) \
+    do {                                                                    \
+        size_t da__n = (new_items_count);                                   \
+        allocator_da_reserve((allocator), (da), (da)->count + da__n);       \
+        memcpy((da)->items + (da)->count, (new_items),                      \
+            da__n*sizeof(*(da)->items));                                    \
+        (da)->count += da__n;                                               \
+    } while(0)
+
+#define allocator_da_free(allocator, da)                                    \
+    do {                                                                    \
+        allocator_free((allocator), (da)->items,                            \
+            (da)->capacity*sizeof(*(da)->items));                           \
+        (da)->items = NULL;                                                 \
+        (da)->count = 0;                                                    \
+        (da)->capacity = 0;                                                 \
+    } while(0)
+
+// Grows through `allocator` when set, release it with sb_free
 typedef struct StringBuilder {
     char *items;
     size_t count;
     size_t capacity;
+    Allocator *allocator;
 } StringBuilder;
 
-int sb_appendf(StringBuilder *sb, const char *fmt, ...);
+void sb_free(StringBuilder *sb);
+
+// All appends keep sb->items NUL-terminated past sb->count
+int  sb_appendf(StringBuilder *sb, const char *fmt, ...);
+void sb_append_buf(StringBuilder *sb, const void *buf, size_t size);
+void sb_append_cstr(StringBuilder *sb, const char *cstr);
+void sb_append_char(StringBuilder *sb, char c);
+void sb_append_int(StringBuilder *sb, int64_t value);
+void sb_append_uint(StringBuilder *sb, uint64_t value);
+// Fixed notation with `precision` digits after the point like "%.*f", but
+// ties round away from zero and values rounding to zero never get a sign
+void sb_append_float(StringBuilder *sb, double value, int precision);
+
+typedef struct StringView {
+    const char *data;
+    size_t count;
+} StringView;
+
+#define SV_Fmt "%.*s"
+#define SV_Arg(sv) (int)(sv).count, (sv).data
+#define SV_STATIC(cstr_lit) { (cstr_lit), sizeof(cstr_lit) - 1 }
+
+StringView sv_from_parts(const char *data, size_t count);
+StringView sv_from_cstr(const char *cstr);
+StringView sb_to_sv(StringBuilder sb);
+bool       sv_eq(StringView a, StringView b);
+uint64_t   sv_hash(StringView sv);
 
 bool read_entire_file(const char *filepath, StringBuilder *sb);
 bool write_entire_file(const char *filepath, const void *data, size_t datasize);
 
+typedef enum FileDurability {
+    // Atomic rename only, the old or new file survives a process crash
+    FILE_DURABILITY_NONE,
+    // Also flush the data and the rename to disk, survives a power loss
+    FILE_DURABILITY_SYNC,
+} FileDurability;
+
+typedef struct FileChunk {
+    const void *data;
+    size_t size;
+} FileChunk;
+
+// Writes to a unique temp file next to `filepath` and renames it over
+// `filepath`, so readers see either the old or the new contents and never
+// a torn file, even when several saves of the same file overlap. The new
+// file keeps the permissions of the one it replaces.
+bool write_entire_file_atomic(const char *filepath, const void *data, size_t datasize, FileDurability durability);
+bool write_entire_file_atomicv(const char *filepath, const FileChunk *chunks, size_t chunks_count, FileDurability durability);
+
+// Read-only view of a whole file. The file is memory mapped when the
+// platform allows it, otherwise it is read into a heap buffer.
+typedef struct FileView {
+    const char *data;
+    size_t size;
+    bool mapped;
+} FileView;
+
+bool file_view_open(const char *filepath, FileView *view);
+void file_view_close(FileView *view);
+
+// Sequential reader that fills caller-owned buffers, so large files can be
+// decoded in fixed-size chunks with bounded memory.
+typedef struct FileReader {
+    FILE *f;
+    size_t size;
+    size_t offset;
+} FileReader;
+
+bool file_reader_open(const char *filepath, FileReader *reader);
+// Reads up to `capacity` bytes. `*nread` is 0 at end of file.
+bool file_reader_read(FileReader *reader, void *buffer, size_t capacity, size_t *nread);
+// Hints that [offset, offset+length) will be read soon. length 0 means up
+// to the end of the file.
+void file_reader_readahead(FileReader *reader, size_t offset, size_t length);
+void file_reader_close(FileReader *reader);
+
 typedef struct ArenaRegion ArenaRegion;
 struct ArenaRegion {
     ArenaRegion *next;
@@ -88,31 +304,94 @@ struct ArenaRegion {
     size_t capacity;
     uintptr_t data[];
 };
+typedef struct ArenaFreeBlock ArenaFreeBlock;
+struct ArenaFreeBlock {
+    ArenaFreeBlock *next;
+    size_t size;
+};
 typedef struct Arena {
     ArenaRegion *begin;
     ArenaRegion *end;
+    ArenaRegion *large;
+    ArenaFreeBlock *free;
+    size_t wasted;
+    Allocator *allocator;
 } Arena;
 
+typedef struct ArenaUsage {
+    size_t used;      // bytes handed out, including wasted ones
+    size_t capacity;  // bytes reserved from the heap
+    size_t wasted;    // bytes abandoned by arena_realloc and not reused yet
+} ArenaUsage;
+
+// A position in an arena. Rewinding to it releases everything allocated
+// after the snapshot in O(1) while older allocations stay valid. Marks are
+// invalidated by arena_reset and arena_free.
+typedef struct ArenaMark {
+    ArenaRegion *region;
+    size_t count;
+    ArenaRegion *large;
+    size_t wasted;
+} ArenaMark;
+
+typedef struct ArenaTemp {
+    Arena *arena;
+    ArenaMark mark;
+} ArenaTemp;
+
 void *arena_alloc(Arena *a, size_t bytesize);
+void *arena_alloc_aligned(Arena *a, size_t bytesize, size_t alignment);
+void *arena_alloc_zero(Arena *a, size_t bytesize, size_t alignment);
+void *arena_realloc(Arena *a, void *old, size_t old_bytesize, size_t new_bytesize);
 void  arena_reset(Arena *a);
 void  arena_free(Arena *a);
 char *arena_strndup(Arena *a, const char *cstr, size_t cstrlen);
 char *arena_strdup(Arena *a, const char *cstr);
 char *arena_sprintf(Arena *a, const char *fmt, ...);
-size_t arena_get_usage(Arena *a);
+ArenaUsage arena_get_usage(Arena *a);
+ArenaMark arena_snapshot(Arena *a);
+void      arena_rewind(Arena *a, ArenaMark mark);
+ArenaTemp arena_temp_begin(Arena *a);
+void      arena_temp_end(ArenaTemp temp);
+
+// Per-thread scratch arenas tied to the frame. Every thread gets two arenas
+// used on alternate frames, so memory from the previous frame stays valid
+// for one more frame. A thread's arena is reset the first time it asks for
+// it in a new frame.
+void   frame_arena_begin(void);
+Arena *frame_arena(void);
+Arena *frame_arena_previous(void);
+// Frees the calling thread's frame arenas, call before the thread exits
+void   frame_arena_thread_free(void);
+
+// Runs the following block with scratch memory from `a` and releases it
+// when the block finishes. Leaving the block with break/return/goto skips
+// the release, use arena_temp_begin/arena_temp_end for those cases.
+#define arena_scope(a)                                                      \
+    for (ArenaTemp arena__temp = arena_temp_begin(a);                       \
+         arena__temp.arena != NULL;                                         \
+         arena_temp_end(arena__temp), arena__temp.arena = NULL)
+
+#define arena_push_array(arena, T, n) \
+    ((T*)arena_alloc_aligned((arena), sizeof(T)*(n), _Alignof(T)))
+#define arena_push_array_zero(arena, T, n) \
+    ((T*)arena_alloc_zero((arena), sizeof(T)*(n), _Alignof(T)))
+#define arena_push_array_aligned(arena, T, n, alignment) \
+    ((T*)arena_alloc_aligned((arena), sizeof(T)*(n), (alignment)))
+#define arena_push_array_aligned_zero(arena, T, n, alignment) \
+    ((T*)arena_alloc_zero((arena), sizeof(T)*(n), (alignment)))
 
 #include <stdio.h>
 #define arena_da_reserve(arena, da, required_cap)                               \
     do {                                                                        \
         size_t item_size = sizeof(*(da)->items);                                \
-        if(required_cap > (da)->capacity) {                                     \
-            if((da)->capacity == 0) (da)->capacity = DA_INIT_CAP;               \
-            while((da)->capacity < required_cap)                                \
-                (da)->capacity *= 2;                                            \
-            void *items = arena_alloc((arena), (da)->capacity * item_size);     \
-            CUT_ASSERT(items != NULL && "Buy More RAM LOL!");                   \
-            if((da)->items) memcpy(items, (da)->items, (da)->count*item_size);  \
-            (da)->items = items;                                                \
+        if((required_cap) > (da)->capacity) {                                   \
+            size_t old_capacity = (da)->capacity;                               \
+            (da)->capacity = da_grow_capacity((da)->capacity,                   \
+                (required_cap), DA_INIT_CAP, DA_GROWTH_FACTOR);                 \
+            (da)->items = arena_realloc((arena), (da)->items,                   \
+                old_capacity*item_size, (da)->capacity*item_size);              \
+            CUT_ASSERT((da)->items != NULL && "Buy More RAM LOL!");             \
         }                                                                       \
     } while(0)
 
@@ -122,4 +401,255 @@ size_t arena_get_usage(Arena *a);
         (da)->items[(da)->count++] = (item);                        \
     } while(0)
 
+#define arena_da_append_many(arena, da, new_items, new_items_count) \
+    do {                                                            \
+        size_t da__n = (new_items_count);                           \
+        arena_da_reserve((arena), (da), (da)->count + da__n);       \
+        memcpy((da)->items + (da)->count, (new_items),              \
+            da__n*sizeof(*(da)->items));                            \
+        (da)->count += da__n;                                       \
+    } while(0)
+
+#define arena_da_extend_uninit(arena, da, n)                        \
+    do {                                                            \
+        size_t da__n = (n);                                         \
+        arena_da_reserve((arena), (da), (da)->count + da__n);       \
+        (da)->count += da__n;                                       \
+    } while(0)
+
+// Open-addressing hash map with Robin Hood probing, generated per key and
+// value type:
+//
+//     HASHMAP_DECLARE(IntMap, intmap, uint64_t, float)
+//     HASHMAP_DEFINE(IntMap, intmap, uint64_t, float, hash_u64, HASHMAP_EQ_SCALAR)
+//
+// `hash_fn(key)` returns a uint64_t and `eq_fn(a, b)` compares two keys. The
+// 32-bit hashes live in their own array so probing touches one cache line
+// for several slots, and a slot with hash 0 is empty. Set `arena` before the
+// first insert to carve the tables from it instead of CUT_MALLOC. Iterate by
+// walking `capacity` slots and skipping those with `hashes[i] == 0`.
+#define HASHMAP_DECLARE(Name, prefix, K, V)                                 \
+    typedef struct Name##Entry {                                            \
+        K key;                                                              \
+        V value;                                                            \
+    } Name##Entry;                                                          \
+    typedef struct Name {                                                   \
+        uint32_t *hashes;                                                   \
+        Name##Entry *entries;                                               \
+        size_t count;                                                       \
+        size_t capacity;                                                    \
+        Arena *arena;                                                       \
+    } Name;                                                                 \
+    V   *prefix##_get(Name *m, K key);                                      \
+    V   *prefix##_put(Name *m, K key, V value);                             \
+    bool prefix##_remove(Name *m, K key);                                   \
+    void prefix##_reserve(Name *m, size_t count);                           \
+    void prefix##_clear(Name *m);                                           \
+    void prefix##_free(Name *m);
+
+#define HASHMAP_DEFINE(Name, prefix, K, V, hash_fn, eq_fn)                  \
+    static uint32_t prefix##__hash(K key)                                   \
+    {                                                                       \
+        uint64_t h = hash_fn(key);                                          \
+        uint32_t result = (uint32_t)(h ^ (h >> 32));                        \
+        return result ? result : 1;                                         \
+    }                                                                       \
+                                                                            \
+    static V *prefix##__insert(Name *m, uint32_t h, Name##Entry e)          \
+    {                                                                       \
+        size_t mask = m->capacity - 1;                                      \
+        size_t i = h & mask;                                                \
+        size_t dist = 0;                                                    \
+        V *result = NULL;                                                   \
+        for (;;) {                                                          \
+            if (m->hashes[i] == 0) {                                        \
+                m->hashes[i] = h;                                           \
+                m->entries[i] = e;                                          \
+                m->count++;                                                 \
+                return result ? result : &m->entries[i].value;              \
+            }                                                               \
+            size_t slot_dist = (i - (m->hashes[i] & mask)) & mask;          \
+            if (slot_dist < dist) {                                         \
+                uint32_t th = m->hashes[i];                                 \
+                Name##Entry te = m->entries[i];                             \
+                m->hashes[i] = h;                                           \
+                m->entries[i] = e;                                          \
+                h = th;                                                     \
+                e = te;                                                     \
+                if (!result) result = &m->entries[i].value;                 \
+                dist = slot_dist;                                           \
+            }                                                               \
+            i = (i + 1) & mask;                                             \
+            dist++;                                                         \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    static void prefix##__resize(Name *m, size_t capacity)                  \
+    {                                                                       \
+        uint32_t *old_hashes = m->hashes;                                   \
+        Name##Entry *old_entries = m->entries;                              \
+        size_t old_capacity = m->capacity;                                  \
+        if (m->arena) {                                                     \
+            m->hashes = arena_push_array_zero(m->arena, uint32_t, capacity);\
+            m->entries = arena_push_array(m->arena, Name##Entry, capacity); \
+        } else {                                                            \
+            m->hashes = CUT_MALLOC(capacity*sizeof(*m->hashes));            \
+            m->entries = CUT_MALLOC(capacity*sizeof(*m->entries));          \
+            CUT_ASSERT(m->hashes && m->entries && "Buy More RAM LOL!");     \
+            memset(m->hashes, 0, capacity*sizeof(*m->hashes));              \
+        }                                                                   \
+        m->capacity = capacity;                                             \
+        m->count = 0;                                                       \
+        for (size_t i = 0; i < old_capacity; ++i) {                         \
+            if (old_hashes[i]) prefix##__insert(m, old_hashes[i], old_entries[i]); \
+        }                                                                   \
+        if (!m->arena) {                                                    \
+            CUT_FREE(old_hashes);                                           \
+            CUT_FREE(old_entries);                                          \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    void prefix##_reserve(Name *m, size_t count)                            \
+    {                                                                       \
+        size_t capacity = m->capacity ? m->capacity : 16;                   \
+        while (count*5 > capacity*4) capacity *= 2;                         \
+        if (capacity != m->capacity) prefix##__resize(m, capacity);         \
+    }                                                                       \
+                                                                            \
+    V *prefix##_get(Name *m, K key)                                         \
+    {                                                                       \
+        if (m->count == 0) return NULL;                                     \
+        uint32_t h = prefix##__hash(key);                                   \
+        size_t mask = m->capacity - 1;                                      \
+        size_t i = h & mask;                                                \
+        for (size_t dist = 0;; ++dist, i = (i + 1) & mask) {                \
+            uint32_t slot_hash = m->hashes[i];                              \
+            if (slot_hash == 0) return NULL;                                \
+            if (((i - (slot_hash & mask)) & mask) < dist) return NULL;      \
+            if (slot_hash == h && eq_fn(m->entries[i].key, key))            \
+                return &m->entries[i].value;                                \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    V *prefix##_put(Name *m, K key, V value)                                \
+    {                                                                       \
+        V *existing = prefix##_get(m, key);                                 \
+        if (existing) {                                                     \
+            *existing = value;                                              \
+            return existing;                                                \
+        }                                                                   \
+        prefix##_reserve(m, m->count + 1);                                  \
+        Name##Entry e;                                                      \
+        e.key = key;                                                        \
+        e.value = value;                                                    \
+        return prefix##__insert(m, prefix##__hash(key), e);                 \
+    }                                                                       \
+                                                                            \
+    bool prefix##_remove(Name *m, K key)                                    \
+    {                                                                       \
+        V *value = prefix##_get(m, key);                                    \
+        if (!value) return false;                                           \
+        size_t mask = m->capacity - 1;                                      \
+        size_t i = (Name##Entry*)((char*)value - offsetof(Name##Entry, value)) - m->entries; \
+        for (;;) {                                                          \
+            size_t next = (i + 1) & mask;                                   \
+            uint32_t nh = m->hashes[next];                                  \
+            if (nh == 0 || ((next - (nh & mask)) & mask) == 0) break;       \
+            m->hashes[i] = nh;                                              \
+            m->entries[i] = m->entries[next];                               \
+            i = next;                                                       \
+        }                                                                   \
+        m->hashes[i] = 0;                                                   \
+        m->count--;                                                         \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    void prefix##_clear(Name *m)                                            \
+    {                                                                       \
+        if (m->hashes) memset(m->hashes, 0, m->capacity*sizeof(*m->hashes));\
+        m->count = 0;                                                       \
+    }                                                                       \
+                                                                            \
+    void prefix##_free(Name *m)                                             \
+    {                                                                       \
+        if (!m->arena) {                                                    \
+            CUT_FREE(m->hashes);                                            \
+            CUT_FREE(m->entries);                                           \
+        }                                                                   \
+        m->hashes = NULL;                                                   \
+        m->entries = NULL;                                                  \
+        m->count = 0;                                                       \
+        m->capacity = 0;                                                    \
+    }
+
+#define HASHMAP_EQ_SCALAR(a, b) ((a) == (b))
+
+// Finalizer from splitmix64, spreads integer keys over all bits
+static inline uint64_t hash_u64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Deduplicates strings into an arena and hands out stable integer IDs, so
+// hot paths compare and look up names by ID instead of by content.
+typedef uint32_t StringID;
+#define INVALID_STRING_ID 0
+
+typedef struct InternedString {
+    StringView sv;
+    uint64_t hash;
+} InternedString;
+
+typedef struct StringInterner {
+    Arena arena;
+    struct {
+        InternedString *items;
+        size_t count;
+        size_t capacity;
+    } strings;
+    StringID *slots;
+    size_t slots_capacity;
+} StringInterner;
+
+StringID   interner_intern(StringInterner *si, StringView sv);
+StringID   interner_intern_cstr(StringInterner *si, const char *cstr);
+// Like interner_intern, but returns INVALID_STRING_ID instead of inserting
+StringID   interner_find(StringInterner *si, StringView sv);
+StringView interner_get(StringInterner *si, StringID id);
+uint64_t   interner_get_hash(StringInterner *si, StringID id);
+void       interner_free(StringInterner *si);
+
+// Thread-safe allocator for objects of one fixed size. Freed objects go to a
+// small per-thread cache first and spill to a lock-free global free list, so
+// threads that churn objects rarely touch shared state. Memory is only given
+// back to the heap by pool_destroy.
+// Every slot carries a header of `alignment` bytes (at least 8) in front of
+// the object holding its own index and free-list link, so pool_free stays
+// O(1) and never touches the object. For objects of 8 bytes or less that
+// doubles the footprint, prefer a plain array there.
+typedef struct Pool Pool;
+
+typedef struct PoolStats {
+    size_t live;        // objects currently handed out
+    size_t peak;        // highest `live` ever seen
+    size_t high_water;  // slots ever carved out of blocks
+    size_t capacity;    // slots in blocks allocated so far
+} PoolStats;
+
+// `alignment` is at most _Alignof(max_align_t), 0 picks the default
+Pool     *pool_create(size_t object_size, size_t alignment);
+void      pool_destroy(Pool *pool);
+// Returns NULL once POOL_MAX_BLOCKS blocks are exhausted
+void     *pool_alloc(Pool *pool);
+void      pool_free(Pool *pool, void *ptr);
+// Returns objects cached by the calling thread to the shared free list.
+// Call before a worker thread exits, or its cached objects stay unusable.
+void      pool_flush_thread_cache(Pool *pool);
+PoolStats pool_get_stats(Pool *pool);
+
 #endif // CUTILS_H_
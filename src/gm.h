@@ -2,11 +2,19 @@
 #define GM_H_
 
 #include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef struct { float x, y; } Vec2;
 typedef struct { float x, y, z; } Vec3;
 typedef struct { float x, y, z, w; } Vec4;
+typedef struct { float data[9]; } Mat3;
 typedef struct { float data[16]; } Mat4;
+// Unit quaternion rotation, w is the scalar part
+typedef struct { float x, y, z, w; } Quat;
+// Row-major 3x4 affine transform: a Mat4 whose last row is always 0 0 0 1
+typedef struct { float data[12]; } Affine3;
 
 #ifndef PI
 #define PI 3.14159265358979323846
@@ -20,6 +28,7 @@ typedef struct { float data[16]; } Mat4;
 #endif
 
 static inline Vec3 vec3(float x, float y, float z) { return (Vec3){ x, y, z }; }
+static inline Vec4 vec4(float x, float y, float z, float w) { return (Vec4){ x, y, z, w }; }
 
 float vec3_dot(Vec3 a, Vec3 b);
 float vec3_length(Vec3 a);
@@ -28,6 +37,11 @@ Vec3  vec3_cross(Vec3 a, Vec3 b);
 Vec3  vec3_sub(Vec3 a, Vec3 b);
 Vec3  vec3_mul_scalar(Vec3 a, float scalar);
 Vec3  vec3_add(Vec3 a, Vec3 b);
+Vec4  vec4_add(Vec4 a, Vec4 b);
+Vec4  vec4_sub(Vec4 a, Vec4 b);
+Vec4  vec4_mul(Vec4 a, Vec4 b);
+Vec4  vec4_mul_scalar(Vec4 a, float scalar);
+float vec4_dot(Vec4 a, Vec4 b);
 Mat4  mat4_eye(float v);
 Mat4  mat4_ortho(float left, float right, float bottom, float top, float far, float near);
 Mat4  mat4_perspective(float fov_radians, float aspect_ratio, float near, float far);
@@ -38,11 +52,161 @@ Mat4  mat4_rotate_x(Mat4 a, float angle_radians);
 Mat4  mat4_rotate_y(Mat4 a, float angle_radians);
 Mat4  mat4_rotate_z(Mat4 a, float angle_radians);
 Mat4  mat4_look_at(Vec3 camera_pos, Vec3 camera_target, Vec3 world_up_dir);
+Vec4  mat4_mul_vec4(Mat4 m, Vec4 v);
+Mat4  mat4_transpose(Mat4 m);
+// Inverse of a matrix whose last row is 0 0 0 1 (translate/rotate/scale)
+Mat4  mat4_inverse_affine(Mat4 m);
+// Post-multiplies `a` by the rotation `q`, like mat4_rotate_x/y/z
+Mat4  mat4_rotate(Mat4 a, Quat q);
+Mat4  mat4_from_quat(Quat q);
+
+// Inverse-transpose of the upper 3x3 of `m`, for transforming normals
+// correctly under non-uniform scale
+Mat3  mat3_normal_from_mat4(Mat4 m);
+Mat3  mat3_transpose(Mat3 m);
+Vec3  mat3_mul_vec3(Mat3 m, Vec3 v);
+
+static inline Quat quat_identity(void) { return (Quat){ 0.0f, 0.0f, 0.0f, 1.0f }; }
+// `axis` must be normalized
+Quat  quat_from_axis_angle(Vec3 axis, float angle_radians);
+// Rotation `b` followed by rotation `a`
+Quat  quat_mul(Quat a, Quat b);
+Quat  quat_normalize(Quat q);
+Quat  quat_slerp(Quat a, Quat b, float t);
+Vec3  quat_rotate_vec3(Quat q, Vec3 v);
+
+// Single precision sine and cosine of the same angle
+void  gm_sincos(float angle_radians, float *s, float *c);
+
+// Opt-in fast math. These trade a little accuracy for speed and are meant
+// for bulk per-entity work; the functions above stay exact.
+//
+// gm_sin_fast/gm_cos_fast/gm_sincos_fast: one range reduction plus minimax
+// polynomials on [-pi/4, pi/4]. Absolute error <= 1e-7 for |x| <= 8192 and
+// <= 1e-6 for |x| <= 1e5; reduce larger angles first.
+float gm_sin_fast(float angle_radians);
+float gm_cos_fast(float angle_radians);
+void  gm_sincos_fast(float angle_radians, float *s, float *c);
+// Hardware reciprocal square root estimate refined by one Newton step,
+// relative error <= 5e-7 on SSE. Falls back to 1/sqrtf without SIMD.
+float gm_rsqrt_fast(float x);
+Vec3  vec3_normalize_fast(Vec3 a);
+
+typedef struct { Vec3 min, max; } AABB;
+typedef struct { Vec3 center; float radius; } Sphere;
+// Points with dot(normal, p) + d >= 0 are on the inner side
+typedef struct { Vec3 normal; float d; } Plane;
+// Left, right, bottom, top, near, far, all facing inwards
+typedef struct { Plane planes[6]; } Frustum;
+
+Plane   plane_normalize(Plane p);
+float   plane_distance(Plane p, Vec3 point);
+// Bounding box of `box` after the transform `m`
+AABB    aabb_transform(AABB box, Mat4 m);
+// `view_proj` is projection * view, planes come out in world space. Pass a
+// full model-view-projection to get them in model space instead.
+Frustum frustum_from_view_proj(Mat4 view_proj);
+// Conservative: may report boxes just outside a frustum corner as visible
+bool    frustum_test_aabb(const Frustum *frustum, AABB box);
+bool    frustum_test_sphere(const Frustum *frustum, Sphere sphere);
+// Sets bit (i % 32) of visible_mask[i / 32] when boxes[i] passes
+// frustum_test_aabb, clearing the others. visible_mask needs
+// (count + 31)/32 words. Tests 4 boxes at a time on SSE, 8 on AVX.
+void    frustum_cull_aabbs(const Frustum *frustum, const AABB *boxes, size_t count, uint32_t *visible_mask);
+
+// Integer grid coordinates for blocks and chunks, exact at any distance
+// from the origin
+typedef struct { int32_t x, y; } IVec2;
+typedef struct { int32_t x, y, z; } IVec3;
+
+static inline IVec2 ivec2(int32_t x, int32_t y) { return (IVec2){ x, y }; }
+static inline IVec3 ivec3(int32_t x, int32_t y, int32_t z) { return (IVec3){ x, y, z }; }
+
+// Division rounding towards negative infinity and the matching
+// non-negative remainder, so -1 / 16 = -1 and -1 mod 16 = 15. `b` > 0.
+static inline int32_t gm_floor_div(int32_t a, int32_t b)
+{
+    int32_t q = a / b;
+    return q - ((a % b) < 0);
+}
+static inline int32_t gm_floor_mod(int32_t a, int32_t b)
+{
+    int32_t r = a % b;
+    return r + ((r < 0) ? b : 0);
+}
+
+IVec2 ivec2_add(IVec2 a, IVec2 b);
+IVec2 ivec2_sub(IVec2 a, IVec2 b);
+IVec3 ivec3_add(IVec3 a, IVec3 b);
+IVec3 ivec3_sub(IVec3 a, IVec3 b);
+bool  ivec3_eq(IVec3 a, IVec3 b);
+IVec3 ivec3_floor_div(IVec3 a, int32_t b);
+IVec3 ivec3_floor_mod(IVec3 a, int32_t b);
+// Block containing a world-space position
+IVec3 ivec3_from_vec3_floor(Vec3 v);
+Vec3  vec3_from_ivec3(IVec3 v);
+
+// World block <-> (chunk, block within chunk) for cubic chunks of
+// `chunk_size` blocks per side; local components are in [0, chunk_size)
+IVec3 world_to_chunk(IVec3 world, int32_t chunk_size);
+IVec3 world_to_local(IVec3 world, int32_t chunk_size);
+IVec3 chunk_local_to_world(IVec3 chunk, IVec3 local, int32_t chunk_size);
+
+// Z-order curves interleave the bits of each coordinate so cells close
+// in space stay close in memory. Coordinates are unsigned: 16 bits each
+// for 2D, 21 bits each for 3D. Uses BMI2 pdep/pext when compiled with it.
+uint32_t morton2_encode(uint32_t x, uint32_t y);
+IVec2    morton2_decode(uint32_t code);
+uint64_t morton3_encode(uint32_t x, uint32_t y, uint32_t z);
+IVec3    morton3_decode(uint64_t code);
+
+// Instance transforms as structure-of-arrays. Rotations are unit quaternions
+// (x, y, z, w). Leave all q* or all s* NULL for no rotation or unit scale.
+typedef struct {
+    const float *px, *py, *pz;
+    const float *qx, *qy, *qz, *qw;
+    const float *sx, *sy, *sz;
+} TransformSoA;
+
+// out[i] = translate * rotate * scale, the same as mat4_translate followed
+// by the rotation and mat4_scale
+void  mat4_batch_model(Mat4 *out, TransformSoA transforms, size_t count);
+// out[i] = view_proj * model(i) without storing the model matrices
+void  mat4_batch_mvp(Mat4 *out, Mat4 view_proj, TransformSoA transforms, size_t count);
+// out[i] = a * bs[i]
+void  mat4_batch_dot(Mat4 *out, Mat4 a, const Mat4 *bs, size_t count);
+
+Affine3 affine3_eye(void);
+Affine3 affine3_from_mat4(Mat4 m);
+Mat4    mat4_from_affine3(Affine3 a);
+Affine3 affine3_dot(Affine3 a, Affine3 b);
+Affine3 affine3_translate(Affine3 a, Vec3 v3);
+Affine3 affine3_scale(Affine3 a, Vec3 v3);
+Affine3 affine3_rotate_x(Affine3 a, float angle_radians);
+Affine3 affine3_rotate_y(Affine3 a, float angle_radians);
+Affine3 affine3_rotate_z(Affine3 a, float angle_radians);
+Vec3    affine3_mul_point(Affine3 a, Vec3 p);
+Vec3    affine3_mul_dir(Affine3 a, Vec3 d);
 
 #endif // GM_H_
 
 #ifdef GM_IMPLEMENTATION
 
+// SIMD paths are picked at compile time from the target flags (-msse2,
+// -mavx, x64 MSVC). Define GM_NO_SIMD to force the scalar code.
+#if !defined(GM_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define GM_SSE
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#define GM_AVX
+#include <immintrin.h>
+#endif
+#endif
+#if !defined(GM_NO_SIMD) && defined(__BMI2__)
+#define GM_BMI2
+#include <immintrin.h>
+#endif
+
 
 float vec3_dot(Vec3 a, Vec3 b)
 {
@@ -86,6 +250,58 @@ Vec3 vec3_add(Vec3 a, Vec3 b)
     return vec3(a.x+b.x, a.y+b.y, a.z+b.z);
 }
 
+Vec4 vec4_add(Vec4 a, Vec4 b)
+{
+#ifdef GM_SSE
+    _mm_storeu_ps(&a.x, _mm_add_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)));
+    return a;
+#else
+    return vec4(a.x+b.x, a.y+b.y, a.z+b.z, a.w+b.w);
+#endif
+}
+
+Vec4 vec4_sub(Vec4 a, Vec4 b)
+{
+#ifdef GM_SSE
+    _mm_storeu_ps(&a.x, _mm_sub_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)));
+    return a;
+#else
+    return vec4(a.x-b.x, a.y-b.y, a.z-b.z, a.w-b.w);
+#endif
+}
+
+Vec4 vec4_mul(Vec4 a, Vec4 b)
+{
+#ifdef GM_SSE
+    _mm_storeu_ps(&a.x, _mm_mul_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)));
+    return a;
+#else
+    return vec4(a.x*b.x, a.y*b.y, a.z*b.z, a.w*b.w);
+#endif
+}
+
+Vec4 vec4_mul_scalar(Vec4 a, float scalar)
+{
+#ifdef GM_SSE
+    _mm_storeu_ps(&a.x, _mm_mul_ps(_mm_loadu_ps(&a.x), _mm_set1_ps(scalar)));
+    return a;
+#else
+    return vec4(a.x*scalar, a.y*scalar, a.z*scalar, a.w*scalar);
+#endif
+}
+
+float vec4_dot(Vec4 a, Vec4 b)
+{
+#ifdef GM_SSE
+    __m128 m = _mm_mul_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x));
+    __m128 s = _mm_add_ps(m, _mm_movehl_ps(m, m));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(s);
+#else
+    return a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+#endif
+}
+
 Mat4 mat4_eye(float v)
 {
     Mat4 res = {0};
@@ -120,12 +336,44 @@ Mat4 mat4_perspective(float fov_radians, float aspect_ratio, float near, float f
     result.data[10] = -((far + near) / (far - near));
     result.data[11] = -((2.0f * far * near) / (far - near));
     result.data[14] = -1.0f;
+    result.data[15] = 0.0f;
     return result;
 }
 
 Mat4 mat4_dot(Mat4 a, Mat4 b)
 {
     Mat4 result;
+#if defined(GM_AVX)
+    // Two rows of the result per iteration: each 128-bit lane broadcasts
+    // the k-th element of its own row of `a` against row k of `b`. The
+    // elements are broadcast straight from memory, a 256-bit load of `a`
+    // plus in-lane shuffles ran at half the speed of the SSE path
+    __m256 b0 = _mm256_broadcast_ps((const __m128*)&b.data[0]);
+    __m256 b1 = _mm256_broadcast_ps((const __m128*)&b.data[4]);
+    __m256 b2 = _mm256_broadcast_ps((const __m128*)&b.data[8]);
+    __m256 b3 = _mm256_broadcast_ps((const __m128*)&b.data[12]);
+    for(int i = 0; i < 16; i += 8) {
+        const float *ar = &a.data[i];
+        __m256 r = _mm256_mul_ps(_mm256_setr_m128(_mm_broadcast_ss(&ar[0]), _mm_broadcast_ss(&ar[4])), b0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_setr_m128(_mm_broadcast_ss(&ar[1]), _mm_broadcast_ss(&ar[5])), b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_setr_m128(_mm_broadcast_ss(&ar[2]), _mm_broadcast_ss(&ar[6])), b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_setr_m128(_mm_broadcast_ss(&ar[3]), _mm_broadcast_ss(&ar[7])), b3));
+        _mm256_storeu_ps(&result.data[i], r);
+    }
+#elif defined(GM_SSE)
+    // Row i of the result is the rows of `b` weighted by row i of `a`
+    __m128 b0 = _mm_loadu_ps(&b.data[0]);
+    __m128 b1 = _mm_loadu_ps(&b.data[4]);
+    __m128 b2 = _mm_loadu_ps(&b.data[8]);
+    __m128 b3 = _mm_loadu_ps(&b.data[12]);
+    for(int i = 0; i < 16; i += 4) {
+        __m128 r = _mm_mul_ps(_mm_set1_ps(a.data[i + 0]), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.data[i + 1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.data[i + 2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.data[i + 3]), b3));
+        _mm_storeu_ps(&result.data[i], r);
+    }
+#else
     for(int i = 0; i < 4; ++i) {
         for(int j = 0; j < 4; ++j) {            
             result.data[i * 4 + j] = 0.0f;
@@ -136,61 +384,321 @@ Mat4 mat4_dot(Mat4 a, Mat4 b)
             }
         }
     }
+#endif
     return result;
 }
 
+// Writes rotation(q) * scale into the upper 3x3 of the row-major 4x4 `d`
+static void gm__quat_rows(float *d, float x, float y, float z, float w, float sx, float sy, float sz)
+{
+    float xx = x*x, yy = y*y, zz = z*z;
+    float xy = x*y, xz = x*z, yz = y*z;
+    float wx = w*x, wy = w*y, wz = w*z;
+    d[0]  = (1.0f - 2.0f*(yy + zz))*sx;
+    d[1]  = 2.0f*(xy - wz)*sy;
+    d[2]  = 2.0f*(xz + wy)*sz;
+    d[4]  = 2.0f*(xy + wz)*sx;
+    d[5]  = (1.0f - 2.0f*(xx + zz))*sy;
+    d[6]  = 2.0f*(yz - wx)*sz;
+    d[8]  = 2.0f*(xz - wy)*sx;
+    d[9]  = 2.0f*(yz + wx)*sy;
+    d[10] = (1.0f - 2.0f*(xx + yy))*sz;
+}
+
+static void gm__model_from_soa(Mat4 *out, const TransformSoA *t, size_t i)
+{
+    float x = 0.0f, y = 0.0f, z = 0.0f, w = 1.0f;
+    float sx = 1.0f, sy = 1.0f, sz = 1.0f;
+    if(t->qx) { x = t->qx[i]; y = t->qy[i]; z = t->qz[i]; w = t->qw[i]; }
+    if(t->sx) { sx = t->sx[i]; sy = t->sy[i]; sz = t->sz[i]; }
+    float *d = out->data;
+    gm__quat_rows(d, x, y, z, w, sx, sy, sz);
+    d[3]  = t->px[i];
+    d[7]  = t->py[i];
+    d[11] = t->pz[i];
+    d[12] = 0.0f;
+    d[13] = 0.0f;
+    d[14] = 0.0f;
+    d[15] = 1.0f;
+}
+
+void mat4_batch_model(Mat4 *out, TransformSoA t, size_t count)
+{
+    size_t i = 0;
+#ifdef GM_SSE
+    // Four instances per step: every matrix element is computed for all
+    // four at once, then each row is transposed back into AoS matrices
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 last_row = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for(; i + 4 <= count; i += 4) {
+        __m128 x = _mm_setzero_ps(), y = x, z = x, w = one;
+        __m128 sx = one, sy = one, sz = one;
+        if(t.qx) {
+            x = _mm_loadu_ps(t.qx + i);
+            y = _mm_loadu_ps(t.qy + i);
+            z = _mm_loadu_ps(t.qz + i);
+            w = _mm_loadu_ps(t.qw + i);
+        }
+        if(t.sx) {
+            sx = _mm_loadu_ps(t.sx + i);
+            sy = _mm_loadu_ps(t.sy + i);
+            sz = _mm_loadu_ps(t.sz + i);
+        }
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        __m128 r0 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        __m128 r1 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        __m128 r2 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        __m128 r3 = _mm_loadu_ps(t.px + i);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(&out[i + 0].data[0], r0);
+        _mm_storeu_ps(&out[i + 1].data[0], r1);
+        _mm_storeu_ps(&out[i + 2].data[0], r2);
+        _mm_storeu_ps(&out[i + 3].data[0], r3);
+
+        r0 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        r1 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        r2 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        r3 = _mm_loadu_ps(t.py + i);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(&out[i + 0].data[4], r0);
+        _mm_storeu_ps(&out[i + 1].data[4], r1);
+        _mm_storeu_ps(&out[i + 2].data[4], r2);
+        _mm_storeu_ps(&out[i + 3].data[4], r3);
+
+        r0 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        r1 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        r2 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        r3 = _mm_loadu_ps(t.pz + i);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(&out[i + 0].data[8], r0);
+        _mm_storeu_ps(&out[i + 1].data[8], r1);
+        _mm_storeu_ps(&out[i + 2].data[8], r2);
+        _mm_storeu_ps(&out[i + 3].data[8], r3);
+
+        for(int k = 0; k < 4; ++k) _mm_storeu_ps(&out[i + k].data[12], last_row);
+    }
+#endif
+    for(; i < count; ++i) gm__model_from_soa(&out[i], &t, i);
+}
+
+void mat4_batch_dot(Mat4 *out, Mat4 a, const Mat4 *bs, size_t count)
+{
+    for(size_t i = 0; i < count; ++i) out[i] = mat4_dot(a, bs[i]);
+}
+
+void mat4_batch_mvp(Mat4 *out, Mat4 view_proj, TransformSoA t, size_t count)
+{
+    // Models are built into `out` one cache-sized block at a time and
+    // multiplied in place while still hot
+    const size_t block = 64;
+    for(size_t i = 0; i < count; i += block) {
+        size_t n = count - i < block ? count - i : block;
+        TransformSoA sub = t;
+        sub.px += i; sub.py += i; sub.pz += i;
+        if(t.qx) { sub.qx += i; sub.qy += i; sub.qz += i; sub.qw += i; }
+        if(t.sx) { sub.sx += i; sub.sy += i; sub.sz += i; }
+        mat4_batch_model(out + i, sub, n);
+        mat4_batch_dot(out + i, view_proj, out + i, n);
+    }
+}
+
+Vec4 mat4_mul_vec4(Mat4 m, Vec4 v)
+{
+#ifdef GM_SSE
+    __m128 r0 = _mm_loadu_ps(&m.data[0]);
+    __m128 r1 = _mm_loadu_ps(&m.data[4]);
+    __m128 r2 = _mm_loadu_ps(&m.data[8]);
+    __m128 r3 = _mm_loadu_ps(&m.data[12]);
+    // Columns of `m` weighted by the components of `v`
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    __m128 r = _mm_mul_ps(r0, _mm_set1_ps(v.x));
+    r = _mm_add_ps(r, _mm_mul_ps(r1, _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_mul_ps(r2, _mm_set1_ps(v.z)));
+    r = _mm_add_ps(r, _mm_mul_ps(r3, _mm_set1_ps(v.w)));
+    _mm_storeu_ps(&v.x, r);
+    return v;
+#else
+    return vec4(
+        m.data[0]*v.x  + m.data[1]*v.y  + m.data[2]*v.z  + m.data[3]*v.w,
+        m.data[4]*v.x  + m.data[5]*v.y  + m.data[6]*v.z  + m.data[7]*v.w,
+        m.data[8]*v.x  + m.data[9]*v.y  + m.data[10]*v.z + m.data[11]*v.w,
+        m.data[12]*v.x + m.data[13]*v.y + m.data[14]*v.z + m.data[15]*v.w);
+#endif
+}
+
+// The transform helpers below post-multiply by a translation, scale or
+// rotation that only differs from identity in one or two columns, so they
+// update those columns of `a` in place instead of doing a full mat4_dot.
+// `rows` is 4 for Mat4 and 3 for Affine3.
+
+static void gm__translate_rows(float *d, int rows, Vec3 v3)
+{
+    for(int r = 0; r < rows; ++r) {
+        float *row = &d[r*4];
+        row[3] += row[0]*v3.x + row[1]*v3.y + row[2]*v3.z;
+    }
+}
+
+static void gm__scale_rows(float *d, int rows, Vec3 v3)
+{
+    for(int r = 0; r < rows; ++r) {
+        float *row = &d[r*4];
+        row[0] *= v3.x;
+        row[1] *= v3.y;
+        row[2] *= v3.z;
+    }
+}
+
+// Columns i and j become (ci*c + cj*s, cj*c - ci*s)
+static void gm__rotate_rows(float *d, int rows, int i, int j, float angle_radians)
+{
+    float s = sinf(angle_radians);
+    float c = cosf(angle_radians);
+    for(int r = 0; r < rows; ++r) {
+        float *row = &d[r*4];
+        float ci = row[i], cj = row[j];
+        row[i] = ci*c + cj*s;
+        row[j] = cj*c - ci*s;
+    }
+}
+
 Mat4 mat4_translate(Mat4 a, Vec3 v3)
 {
-    Mat4 result = mat4_eye(1.0f);
-    result.data[3]  = v3.x;
-    result.data[7]  = v3.y;
-    result.data[11] = v3.z;
-    return mat4_dot(a, result);
+    gm__translate_rows(a.data, 4, v3);
+    return a;
 }
 
 Mat4 mat4_scale(Mat4 a, Vec3 v3)
 {
-    Mat4 result = mat4_eye(1.0f);
-    result.data[0]  = v3.x;
-    result.data[5]  = v3.y;
-    result.data[10] = v3.z;
-    return mat4_dot(a, result);
+    gm__scale_rows(a.data, 4, v3);
+    return a;
 }
 
 Mat4 mat4_rotate_x(Mat4 a, float angle_radians)
 {
-    Mat4 result = mat4_eye(1.0f);
-    float s = sin(angle_radians);
-    float c = cos(angle_radians);
-    result.data[5]  =  c;
-    result.data[6]  = -s;
-    result.data[9]  =  s;
-    result.data[10] =  c;
-    return mat4_dot(a, result);
+    gm__rotate_rows(a.data, 4, 1, 2, angle_radians);
+    return a;
 }
 
 Mat4 mat4_rotate_y(Mat4 a, float angle_radians)
 {
-    Mat4 result = mat4_eye(1.0f);
-    float s = sin(angle_radians);
-    float c = cos(angle_radians);
-    result.data[0]  =  c;
-    result.data[2]  =  s;
-    result.data[8]  = -s;
-    result.data[10] =  c;
-    return mat4_dot(a, result);
+    gm__rotate_rows(a.data, 4, 2, 0, angle_radians);
+    return a;
 }
 
 Mat4 mat4_rotate_z(Mat4 a, float angle_radians)
 {
-    Mat4 result = mat4_eye(1.0f);
-    float s = sin(angle_radians);
-    float c = cos(angle_radians);
-    result.data[0]  =  c;
-    result.data[1]  = -s;
-    result.data[4]  =  s;
-    result.data[5]  =  c;
-    return mat4_dot(a, result);
+    gm__rotate_rows(a.data, 4, 0, 1, angle_radians);
+    return a;
+}
+
+Affine3 affine3_eye(void)
+{
+    Affine3 res = {0};
+    res.data[0] = 1.0f;
+    res.data[5] = 1.0f;
+    res.data[10] = 1.0f;
+    return res;
+}
+
+Affine3 affine3_from_mat4(Mat4 m)
+{
+    Affine3 res;
+    for(int i = 0; i < 12; ++i) res.data[i] = m.data[i];
+    return res;
+}
+
+Mat4 mat4_from_affine3(Affine3 a)
+{
+    Mat4 res;
+    for(int i = 0; i < 12; ++i) res.data[i] = a.data[i];
+    res.data[12] = 0.0f;
+    res.data[13] = 0.0f;
+    res.data[14] = 0.0f;
+    res.data[15] = 1.0f;
+    return res;
+}
+
+// 36 multiplies and 27 adds against 64 and 48 for mat4_dot, since the
+// implicit last row of `b` is 0 0 0 1
+Affine3 affine3_dot(Affine3 a, Affine3 b)
+{
+    Affine3 result;
+#ifdef GM_SSE
+    __m128 b0 = _mm_loadu_ps(&b.data[0]);
+    __m128 b1 = _mm_loadu_ps(&b.data[4]);
+    __m128 b2 = _mm_loadu_ps(&b.data[8]);
+    __m128 w  = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for(int i = 0; i < 12; i += 4) {
+        __m128 r = _mm_mul_ps(_mm_set1_ps(a.data[i + 0]), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.data[i + 1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.data[i + 2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.data[i + 3]), w));
+        _mm_storeu_ps(&result.data[i], r);
+    }
+#else
+    for(int i = 0; i < 3; ++i) {
+        const float *ar = &a.data[i*4];
+        for(int j = 0; j < 4; ++j) {
+            result.data[i*4 + j] =
+                ar[0]*b.data[j] + ar[1]*b.data[4 + j] + ar[2]*b.data[8 + j];
+        }
+        result.data[i*4 + 3] += ar[3];
+    }
+#endif
+    return result;
+}
+
+Affine3 affine3_translate(Affine3 a, Vec3 v3)
+{
+    gm__translate_rows(a.data, 3, v3);
+    return a;
+}
+
+Affine3 affine3_scale(Affine3 a, Vec3 v3)
+{
+    gm__scale_rows(a.data, 3, v3);
+    return a;
+}
+
+Affine3 affine3_rotate_x(Affine3 a, float angle_radians)
+{
+    gm__rotate_rows(a.data, 3, 1, 2, angle_radians);
+    return a;
+}
+
+Affine3 affine3_rotate_y(Affine3 a, float angle_radians)
+{
+    gm__rotate_rows(a.data, 3, 2, 0, angle_radians);
+    return a;
+}
+
+Affine3 affine3_rotate_z(Affine3 a, float angle_radians)
+{
+    gm__rotate_rows(a.data, 3, 0, 1, angle_radians);
+    return a;
+}
+
+Vec3 affine3_mul_point(Affine3 a, Vec3 p)
+{
+    const float *d = a.data;
+    return vec3(
+        d[0]*p.x + d[1]*p.y + d[2]*p.z  + d[3],
+        d[4]*p.x + d[5]*p.y + d[6]*p.z  + d[7],
+        d[8]*p.x + d[9]*p.y + d[10]*p.z + d[11]);
+}
+
+Vec3 affine3_mul_dir(Affine3 a, Vec3 d3)
+{
+    const float *d = a.data;
+    return vec3(
+        d[0]*d3.x + d[1]*d3.y + d[2]*d3.z,
+        d[4]*d3.x + d[5]*d3.y + d[6]*d3.z,
+        d[8]*d3.x + d[9]*d3.y + d[10]*d3.z);
 }
 
 Mat4 mat4_look_at(Vec3 camera_pos, Vec3 camera_target, Vec3 world_up_dir)
@@ -216,4 +724,529 @@ Mat4 mat4_look_at(Vec3 camera_pos, Vec3 camera_target, Vec3 world_up_dir)
     return result;
 }
 
+Mat4 mat4_transpose(Mat4 m)
+{
+#ifdef GM_SSE
+    __m128 r0 = _mm_loadu_ps(&m.data[0]);
+    __m128 r1 = _mm_loadu_ps(&m.data[4]);
+    __m128 r2 = _mm_loadu_ps(&m.data[8]);
+    __m128 r3 = _mm_loadu_ps(&m.data[12]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(&m.data[0], r0);
+    _mm_storeu_ps(&m.data[4], r1);
+    _mm_storeu_ps(&m.data[8], r2);
+    _mm_storeu_ps(&m.data[12], r3);
+    return m;
+#else
+    Mat4 result;
+    for(int i = 0; i < 4; ++i) {
+        for(int j = 0; j < 4; ++j) {
+            result.data[i*4 + j] = m.data[j*4 + i];
+        }
+    }
+    return result;
+#endif
+}
+
+// Cofactors of the upper 3x3 of `m`, laid out as the transposed adjugate:
+// inverse = transpose(cof) / det and inverse-transpose = cof / det
+static float gm__cofactors3(Mat4 m, float cof[9])
+{
+    const float *d = m.data;
+    cof[0] = d[5]*d[10] - d[6]*d[9];
+    cof[1] = d[6]*d[8]  - d[4]*d[10];
+    cof[2] = d[4]*d[9]  - d[5]*d[8];
+    cof[3] = d[2]*d[9]  - d[1]*d[10];
+    cof[4] = d[0]*d[10] - d[2]*d[8];
+    cof[5] = d[1]*d[8]  - d[0]*d[9];
+    cof[6] = d[1]*d[6]  - d[2]*d[5];
+    cof[7] = d[2]*d[4]  - d[0]*d[6];
+    cof[8] = d[0]*d[5]  - d[1]*d[4];
+    return d[0]*cof[0] + d[1]*cof[1] + d[2]*cof[2];
+}
+
+Mat4 mat4_inverse_affine(Mat4 m)
+{
+    float cof[9];
+    float det = gm__cofactors3(m, cof);
+    float inv_det = det != 0.0f ? 1.0f/det : 0.0f;
+    Mat4 result = mat4_eye(1.0f);
+    for(int i = 0; i < 3; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            result.data[i*4 + j] = cof[j*3 + i]*inv_det;
+        }
+    }
+    float tx = m.data[3], ty = m.data[7], tz = m.data[11];
+    for(int i = 0; i < 3; ++i) {
+        float *row = &result.data[i*4];
+        row[3] = -(row[0]*tx + row[1]*ty + row[2]*tz);
+    }
+    return result;
+}
+
+Mat4 mat4_rotate(Mat4 a, Quat q)
+{
+    Mat4 r;
+    gm__quat_rows(r.data, q.x, q.y, q.z, q.w, 1.0f, 1.0f, 1.0f);
+    for(int i = 0; i < 4; ++i) {
+        float *row = &a.data[i*4];
+        float c0 = row[0], c1 = row[1], c2 = row[2];
+        row[0] = c0*r.data[0] + c1*r.data[4] + c2*r.data[8];
+        row[1] = c0*r.data[1] + c1*r.data[5] + c2*r.data[9];
+        row[2] = c0*r.data[2] + c1*r.data[6] + c2*r.data[10];
+    }
+    return a;
+}
+
+Mat4 mat4_from_quat(Quat q)
+{
+    Mat4 result = mat4_eye(1.0f);
+    gm__quat_rows(result.data, q.x, q.y, q.z, q.w, 1.0f, 1.0f, 1.0f);
+    return result;
+}
+
+Mat3 mat3_normal_from_mat4(Mat4 m)
+{
+    Mat3 result;
+    float det = gm__cofactors3(m, result.data);
+    float inv_det = det != 0.0f ? 1.0f/det : 0.0f;
+    for(int i = 0; i < 9; ++i) result.data[i] *= inv_det;
+    return result;
+}
+
+Mat3 mat3_transpose(Mat3 m)
+{
+    Mat3 result;
+    for(int i = 0; i < 3; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            result.data[i*3 + j] = m.data[j*3 + i];
+        }
+    }
+    return result;
+}
+
+Vec3 mat3_mul_vec3(Mat3 m, Vec3 v)
+{
+    return vec3(
+        m.data[0]*v.x + m.data[1]*v.y + m.data[2]*v.z,
+        m.data[3]*v.x + m.data[4]*v.y + m.data[5]*v.z,
+        m.data[6]*v.x + m.data[7]*v.y + m.data[8]*v.z);
+}
+
+Quat quat_from_axis_angle(Vec3 axis, float angle_radians)
+{
+    float s = sinf(angle_radians*0.5f);
+    float c = cosf(angle_radians*0.5f);
+    return (Quat){ axis.x*s, axis.y*s, axis.z*s, c };
+}
+
+Quat quat_mul(Quat a, Quat b)
+{
+    return (Quat){
+        a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y,
+        a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x,
+        a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w,
+        a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z,
+    };
+}
+
+Quat quat_normalize(Quat q)
+{
+    float len_sqr = q.x*q.x + q.y*q.y + q.z*q.z + q.w*q.w;
+    if(len_sqr == 0.0f) return quat_identity();
+    float inv = 1.0f/sqrtf(len_sqr);
+    return (Quat){ q.x*inv, q.y*inv, q.z*inv, q.w*inv };
+}
+
+Quat quat_slerp(Quat a, Quat b, float t)
+{
+    float cos_theta = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+    // Take the short way around
+    if(cos_theta < 0.0f) {
+        b = (Quat){ -b.x, -b.y, -b.z, -b.w };
+        cos_theta = -cos_theta;
+    }
+    float wa, wb;
+    if(cos_theta > 0.9995f) {
+        // Nearly parallel: lerp and renormalize avoids dividing by ~0
+        wa = 1.0f - t;
+        wb = t;
+    } else {
+        float theta = acosf(cos_theta);
+        float inv_sin = 1.0f/sinf(theta);
+        wa = sinf((1.0f - t)*theta)*inv_sin;
+        wb = sinf(t*theta)*inv_sin;
+    }
+    return quat_normalize((Quat){
+        a.x*wa + b.x*wb, a.y*wa + b.y*wb, a.z*wa + b.z*wb, a.w*wa + b.w*wb,
+    });
+}
+
+Vec3 quat_rotate_vec3(Quat q, Vec3 v)
+{
+    // v + 2w(u x v) + 2u x (u x v), u = q.xyz
+    Vec3 u = vec3(q.x, q.y, q.z);
+    Vec3 t = vec3_mul_scalar(vec3_cross(u, v), 2.0f);
+    return vec3_add(vec3_add(v, vec3_mul_scalar(t, q.w)), vec3_cross(u, t));
+}
+
+void gm_sincos(float angle_radians, float *s, float *c)
+{
+    *s = sinf(angle_radians);
+    *c = cosf(angle_radians);
+}
+
+// Reduces x to r in [-pi/4, pi/4] with x = r + k*pi/2 and evaluates both
+// polynomials. pi/2 is split in three so k*GM__PIO2_A stays exact.
+#define GM__2_OVER_PI 0.63661977236758134f
+#define GM__PIO2_A    1.5703125f
+#define GM__PIO2_B    4.837512969970703125e-4f
+#define GM__PIO2_C    7.54978995489188216e-8f
+
+static int gm__sincos_reduced(float x, float *sr, float *cr)
+{
+    // Round to nearest by adding and removing 1.5*2^23, which is cheaper
+    // than floorf/nearbyintf on targets without SSE4.1 and has no branch
+    float k = (x*GM__2_OVER_PI + 12582912.0f) - 12582912.0f;
+    int q = (int)k;
+    float r = ((x - k*GM__PIO2_A) - k*GM__PIO2_B) - k*GM__PIO2_C;
+    float r2 = r*r;
+    *sr = r + r*r2*(-1.6666654611e-1f + r2*(8.3321608736e-3f + r2*-1.9515295891e-4f));
+    *cr = 1.0f - 0.5f*r2 + r2*r2*(4.166664568298827e-2f + r2*(-1.388731625493765e-3f + r2*2.443315711809948e-5f));
+    return q & 3;
+}
+
+void gm_sincos_fast(float angle_radians, float *s, float *c)
+{
+    float sr, cr;
+    int q = gm__sincos_reduced(angle_radians, &sr, &cr);
+    // Quadrant fix-up without branches, since random angles make a switch
+    // mispredict: odd quadrants swap sin and cos, bit 1 flips the signs
+    uint32_t swap = -(uint32_t)(q & 1);
+    union { float f; uint32_t u; } sb = { sr }, cb = { cr }, so, co;
+    so.u = ((sb.u & ~swap) | (cb.u & swap)) ^ ((uint32_t)(q & 2) << 30);
+    co.u = ((cb.u & ~swap) | (sb.u & swap)) ^ ((uint32_t)((q + 1) & 2) << 30);
+    *s = so.f;
+    *c = co.f;
+}
+
+float gm_sin_fast(float angle_radians)
+{
+    float s, c;
+    gm_sincos_fast(angle_radians, &s, &c);
+    return s;
+}
+
+float gm_cos_fast(float angle_radians)
+{
+    float s, c;
+    gm_sincos_fast(angle_radians, &s, &c);
+    return c;
+}
+
+float gm_rsqrt_fast(float x)
+{
+#ifdef GM_SSE
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    // One Newton-Raphson step takes the ~12-bit estimate to ~22 bits
+    return y*(1.5f - 0.5f*x*y*y);
+#else
+    return 1.0f/sqrtf(x);
+#endif
+}
+
+Vec3 vec3_normalize_fast(Vec3 a)
+{
+    float length_sqr = a.x*a.x + a.y*a.y + a.z*a.z;
+    if(length_sqr == 0.0f) return a;
+    return vec3_mul_scalar(a, gm_rsqrt_fast(length_sqr));
+}
+
+Plane plane_normalize(Plane p)
+{
+    float length = vec3_length(p.normal);
+    if(length == 0.0f) return p;
+    float ilength = 1.0f/length;
+    p.normal = vec3_mul_scalar(p.normal, ilength);
+    p.d *= ilength;
+    return p;
+}
+
+float plane_distance(Plane p, Vec3 point)
+{
+    return vec3_dot(p.normal, point) + p.d;
+}
+
+AABB aabb_transform(AABB box, Mat4 m)
+{
+    // Transform the center, then grow the extents by |m| (Arvo)
+    Vec3 c = vec3_mul_scalar(vec3_add(box.min, box.max), 0.5f);
+    Vec3 e = vec3_mul_scalar(vec3_sub(box.max, box.min), 0.5f);
+    float center[3], extent[3];
+    for(int i = 0; i < 3; ++i) {
+        const float *row = &m.data[i*4];
+        center[i] = row[0]*c.x + row[1]*c.y + row[2]*c.z + row[3];
+        extent[i] = fabsf(row[0])*e.x + fabsf(row[1])*e.y + fabsf(row[2])*e.z;
+    }
+    AABB result;
+    result.min = vec3(center[0] - extent[0], center[1] - extent[1], center[2] - extent[2]);
+    result.max = vec3(center[0] + extent[0], center[1] + extent[1], center[2] + extent[2]);
+    return result;
+}
+
+Frustum frustum_from_view_proj(Mat4 view_proj)
+{
+    // Gribb-Hartmann: with clip = M * v, the clip-space conditions
+    // -w <= x,y,z <= w become sums and differences of the rows of M
+    const float *m = view_proj.data;
+    Frustum f;
+    for(int i = 0; i < 6; ++i) {
+        const float *row = &m[(i/2)*4];
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        Plane p;
+        p.normal = vec3(m[12] + sign*row[0], m[13] + sign*row[1], m[14] + sign*row[2]);
+        p.d = m[15] + sign*row[3];
+        f.planes[i] = plane_normalize(p);
+    }
+    return f;
+}
+
+bool frustum_test_aabb(const Frustum *frustum, AABB box)
+{
+    Vec3 c = vec3_mul_scalar(vec3_add(box.min, box.max), 0.5f);
+    Vec3 e = vec3_mul_scalar(vec3_sub(box.max, box.min), 0.5f);
+    for(int i = 0; i < 6; ++i) {
+        Plane p = frustum->planes[i];
+        float r = fabsf(p.normal.x)*e.x + fabsf(p.normal.y)*e.y + fabsf(p.normal.z)*e.z;
+        if(plane_distance(p, c) + r < 0.0f) return false;
+    }
+    return true;
+}
+
+bool frustum_test_sphere(const Frustum *frustum, Sphere sphere)
+{
+    for(int i = 0; i < 6; ++i) {
+        if(plane_distance(frustum->planes[i], sphere.center) < -sphere.radius) return false;
+    }
+    return true;
+}
+
+void frustum_cull_aabbs(const Frustum *frustum, const AABB *boxes, size_t count, uint32_t *visible_mask)
+{
+    size_t words = (count + 31)/32;
+    for(size_t i = 0; i < words; ++i) visible_mask[i] = 0;
+    size_t i = 0;
+    // Boxes are gathered into center/extent lanes and tested against one
+    // plane at a time; a lane is culled once any plane rejects it
+#if defined(GM_AVX)
+    const __m256 half8 = _mm256_set1_ps(0.5f);
+    for(; i + 8 <= count; i += 8) {
+        const AABB *b = &boxes[i];
+#define GM__LANES8(field) _mm256_setr_ps(b[0].field, b[1].field, b[2].field, b[3].field, \
+                                         b[4].field, b[5].field, b[6].field, b[7].field)
+        __m256 minx = GM__LANES8(min.x), miny = GM__LANES8(min.y), minz = GM__LANES8(min.z);
+        __m256 maxx = GM__LANES8(max.x), maxy = GM__LANES8(max.y), maxz = GM__LANES8(max.z);
+#undef GM__LANES8
+        __m256 cx = _mm256_mul_ps(_mm256_add_ps(minx, maxx), half8);
+        __m256 cy = _mm256_mul_ps(_mm256_add_ps(miny, maxy), half8);
+        __m256 cz = _mm256_mul_ps(_mm256_add_ps(minz, maxz), half8);
+        __m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxx, minx), half8);
+        __m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxy, miny), half8);
+        __m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxz, minz), half8);
+        __m256 outside = _mm256_setzero_ps();
+        for(int p = 0; p < 6; ++p) {
+            Plane pl = frustum->planes[p];
+            __m256 dist = _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(pl.normal.x)), _mm256_set1_ps(pl.d));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cy, _mm256_set1_ps(pl.normal.y)));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cz, _mm256_set1_ps(pl.normal.z)));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(ex, _mm256_set1_ps(fabsf(pl.normal.x))));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(ey, _mm256_set1_ps(fabsf(pl.normal.y))));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(ez, _mm256_set1_ps(fabsf(pl.normal.z))));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        uint32_t bits = ~(uint32_t)_mm256_movemask_ps(outside) & 0xFFu;
+        visible_mask[i/32] |= bits << (i % 32);
+    }
+#endif
+#if defined(GM_SSE)
+    const __m128 half = _mm_set1_ps(0.5f);
+    for(; i + 4 <= count; i += 4) {
+        const AABB *b = &boxes[i];
+#define GM__LANES4(field) _mm_setr_ps(b[0].field, b[1].field, b[2].field, b[3].field)
+        __m128 minx = GM__LANES4(min.x), miny = GM__LANES4(min.y), minz = GM__LANES4(min.z);
+        __m128 maxx = GM__LANES4(max.x), maxy = GM__LANES4(max.y), maxz = GM__LANES4(max.z);
+#undef GM__LANES4
+        __m128 cx = _mm_mul_ps(_mm_add_ps(minx, maxx), half);
+        __m128 cy = _mm_mul_ps(_mm_add_ps(miny, maxy), half);
+        __m128 cz = _mm_mul_ps(_mm_add_ps(minz, maxz), half);
+        __m128 ex = _mm_mul_ps(_mm_sub_ps(maxx, minx), half);
+        __m128 ey = _mm_mul_ps(_mm_sub_ps(maxy, miny), half);
+        __m128 ez = _mm_mul_ps(_mm_sub_ps(maxz, minz), half);
+        __m128 outside = _mm_setzero_ps();
+        for(int p = 0; p < 6; ++p) {
+            Plane pl = frustum->planes[p];
+            __m128 dist = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(pl.normal.x)), _mm_set1_ps(pl.d));
+            dist = _mm_add_ps(dist, _mm_mul_ps(cy, _mm_set1_ps(pl.normal.y)));
+            dist = _mm_add_ps(dist, _mm_mul_ps(cz, _mm_set1_ps(pl.normal.z)));
+            dist = _mm_add_ps(dist, _mm_mul_ps(ex, _mm_set1_ps(fabsf(pl.normal.x))));
+            dist = _mm_add_ps(dist, _mm_mul_ps(ey, _mm_set1_ps(fabsf(pl.normal.y))));
+            dist = _mm_add_ps(dist, _mm_mul_ps(ez, _mm_set1_ps(fabsf(pl.normal.z))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_setzero_ps()));
+        }
+        uint32_t bits = ~(uint32_t)_mm_movemask_ps(outside) & 0xFu;
+        visible_mask[i/32] |= bits << (i % 32);
+    }
+#endif
+    for(; i < count; ++i) {
+        if(frustum_test_aabb(frustum, boxes[i])) visible_mask[i/32] |= 1u << (i % 32);
+    }
+}
+
+IVec2 ivec2_add(IVec2 a, IVec2 b)
+{
+    return ivec2(a.x + b.x, a.y + b.y);
+}
+
+IVec2 ivec2_sub(IVec2 a, IVec2 b)
+{
+    return ivec2(a.x - b.x, a.y - b.y);
+}
+
+IVec3 ivec3_add(IVec3 a, IVec3 b)
+{
+    return ivec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+IVec3 ivec3_sub(IVec3 a, IVec3 b)
+{
+    return ivec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+bool ivec3_eq(IVec3 a, IVec3 b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+IVec3 ivec3_floor_div(IVec3 a, int32_t b)
+{
+    return ivec3(gm_floor_div(a.x, b), gm_floor_div(a.y, b), gm_floor_div(a.z, b));
+}
+
+IVec3 ivec3_floor_mod(IVec3 a, int32_t b)
+{
+    return ivec3(gm_floor_mod(a.x, b), gm_floor_mod(a.y, b), gm_floor_mod(a.z, b));
+}
+
+IVec3 ivec3_from_vec3_floor(Vec3 v)
+{
+    return ivec3((int32_t)floorf(v.x), (int32_t)floorf(v.y), (int32_t)floorf(v.z));
+}
+
+Vec3 vec3_from_ivec3(IVec3 v)
+{
+    return vec3((float)v.x, (float)v.y, (float)v.z);
+}
+
+IVec3 world_to_chunk(IVec3 world, int32_t chunk_size)
+{
+    return ivec3_floor_div(world, chunk_size);
+}
+
+IVec3 world_to_local(IVec3 world, int32_t chunk_size)
+{
+    return ivec3_floor_mod(world, chunk_size);
+}
+
+IVec3 chunk_local_to_world(IVec3 chunk, IVec3 local, int32_t chunk_size)
+{
+    return ivec3(chunk.x*chunk_size + local.x, chunk.y*chunk_size + local.y, chunk.z*chunk_size + local.z);
+}
+
+#define GM__MORTON2_X 0x55555555u
+#define GM__MORTON3_X 0x1249249249249249ull
+
+#ifndef GM_BMI2
+// Spread the low bits of v so there is one (2D) or two (3D) zero bits
+// between each of them, and the inverse
+static uint32_t gm__part1by1(uint32_t v)
+{
+    v &= 0x0000ffffu;
+    v = (v | (v << 8)) & 0x00ff00ffu;
+    v = (v | (v << 4)) & 0x0f0f0f0fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+static uint32_t gm__compact1by1(uint32_t v)
+{
+    v &= 0x55555555u;
+    v = (v | (v >> 1)) & 0x33333333u;
+    v = (v | (v >> 2)) & 0x0f0f0f0fu;
+    v = (v | (v >> 4)) & 0x00ff00ffu;
+    v = (v | (v >> 8)) & 0x0000ffffu;
+    return v;
+}
+
+static uint64_t gm__part1by2(uint64_t v)
+{
+    v &= 0x1fffffull;
+    v = (v | (v << 32)) & 0x1f00000000ffffull;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffull;
+    v = (v | (v << 8))  & 0x100f00f00f00f00full;
+    v = (v | (v << 4))  & 0x10c30c30c30c30c3ull;
+    v = (v | (v << 2))  & 0x1249249249249249ull;
+    return v;
+}
+
+static uint64_t gm__compact1by2(uint64_t v)
+{
+    v &= 0x1249249249249249ull;
+    v = (v | (v >> 2))  & 0x10c30c30c30c30c3ull;
+    v = (v | (v >> 4))  & 0x100f00f00f00f00full;
+    v = (v | (v >> 8))  & 0x1f0000ff0000ffull;
+    v = (v | (v >> 16)) & 0x1f00000000ffffull;
+    v = (v | (v >> 32)) & 0x1fffffull;
+    return v;
+}
+#endif
+
+uint32_t morton2_encode(uint32_t x, uint32_t y)
+{
+#ifdef GM_BMI2
+    return _pdep_u32(x, GM__MORTON2_X) | _pdep_u32(y, GM__MORTON2_X << 1);
+#else
+    return gm__part1by1(x) | (gm__part1by1(y) << 1);
+#endif
+}
+
+IVec2 morton2_decode(uint32_t code)
+{
+#ifdef GM_BMI2
+    return ivec2((int32_t)_pext_u32(code, GM__MORTON2_X), (int32_t)_pext_u32(code, GM__MORTON2_X << 1));
+#else
+    return ivec2((int32_t)gm__compact1by1(code), (int32_t)gm__compact1by1(code >> 1));
+#endif
+}
+
+uint64_t morton3_encode(uint32_t x, uint32_t y, uint32_t z)
+{
+#ifdef GM_BMI2
+    return _pdep_u64(x, GM__MORTON3_X) | _pdep_u64(y, GM__MORTON3_X << 1) | _pdep_u64(z, GM__MORTON3_X << 2);
+#else
+    return gm__part1by2(x) | (gm__part1by2(y) << 1) | (gm__part1by2(z) << 2);
+#endif
+}
+
+IVec3 morton3_decode(uint64_t code)
+{
+#ifdef GM_BMI2
+    return ivec3((int32_t)_pext_u64(code, GM__MORTON3_X),
+                 (int32_t)_pext_u64(code, GM__MORTON3_X << 1),
+                 (int32_t)_pext_u64(code, GM__MORTON3_X << 2));
+#else
+    return ivec3((int32_t)gm__compact1by2(code), (int32_t)gm__compact1by2(code >> 1), (int32_t)gm__compact1by2(code >> 2));
+#endif
+}
+
 #endif // GM_IMPLEMENTATION
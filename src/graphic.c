@@ -16,9 +16,29 @@
 #define DEBUG_INFO(...)
 #endif
 
+typedef struct Uniform {
+    StringView name;
+    GLint location;
+    GLenum type;
+    GLint size;
+    // Last value uploaded, so setting the same value again is skipped
+    float value[16];
+    int cached;
+} Uniform;
+
+HASHMAP_DECLARE(UniformTable, uniform_table, StringView, UniformID)
+HASHMAP_DEFINE(UniformTable, uniform_table, StringView, UniformID, sv_hash, sv_eq)
+
 typedef struct Shader {
     int init;
     GLuint program;
+    // Active uniforms reflected at link time, UniformID is index + 1
+    struct {
+        Uniform *items;
+        size_t count;
+        size_t capacity;
+    } uniforms;
+    UniformTable uniform_table;
 } Shader;
 
 typedef struct Texture {
@@ -27,6 +47,35 @@ typedef struct Texture {
 } Texture;
 
 #define MAX_SHADER 32
+#define MAX_TEXTURE_UNITS 16
+#define STATE_UNKNOWN ((GLuint)-1)
+
+// std140 mirror of the FrameData block described in graphic.h, vec4s keep
+// every member on a 16 byte boundary
+typedef struct FrameData {
+    Mat4 view;
+    Mat4 projection;
+    Mat4 view_proj;
+    Vec4 camera_pos;
+    Vec4 light_pos;
+    Vec4 light_color;
+} FrameData;
+_Static_assert(sizeof(FrameData) == 240, "FrameData must match the std140 layout");
+
+// Mirror of the GL state the renderer changes. Starts out as the GL
+// defaults; STATE_UNKNOWN forces the next call through.
+typedef struct RenderState {
+    GLuint program;
+    GLuint vertex_array;
+    GLuint array_buffer;
+    // Part of the VAO state, forgotten whenever the VAO changes
+    GLuint element_array_buffer;
+    GLuint uniform_buffer;
+    GLuint active_texture_unit;
+    GLuint textures[MAX_TEXTURE_UNITS];
+    GLuint depth_test;
+    GLuint blend;
+} RenderState;
 
 typedef struct Renderer {
     // TODO: This must be a table instead of a plain dynamic array
@@ -40,22 +89,86 @@ typedef struct Renderer {
         size_t count;
         size_t capacity;
     } textures;
+    Allocator *allocator;
+    // Uniform names and tables, lives as long as the renderer
+    Arena arena;
+    RenderState state;
+    RenderStats stats;
+    RenderStats last_frame_stats;
+    GLuint frame_ubo;
+    FrameData frame_data;
 } Renderer;
 
-Renderer *render_init(void)
+// Updates the cached `*slot` and returns true when `value` differs from
+// it, i.e. when the GL call has to be issued
+static bool state_update(Renderer *ren, GLuint *slot, GLuint value)
+{
+    if(*slot == value) {
+        ren->stats.elided += 1;
+        return false;
+    }
+    *slot = value;
+    ren->stats.issued += 1;
+    return true;
+}
+
+Renderer *render_init(Allocator *allocator)
 {
     Renderer *ren;
-    ren = malloc(sizeof(*ren));
+    ren = allocator_alloc(allocator, sizeof(*ren));
     memset(ren, 0, sizeof(*ren));
+    ren->allocator = allocator;
+    ren->arena.allocator = allocator;
     // stubs
-    da_append(&ren->shaders,  ((Shader){.init=1}));
-    da_append(&ren->textures, ((Texture){.init=1}));
+    allocator_da_append(ren->allocator, &ren->shaders,  ((Shader){.init=1}));
+    allocator_da_append(ren->allocator, &ren->textures, ((Texture){.init=1}));
     return ren;
 }
 
 void render_close(Renderer *ren)
 {
-    if(ren) free(ren);
+    if(!ren) return;
+    allocator_da_free(ren->allocator, &ren->shaders);
+    allocator_da_free(ren->allocator, &ren->textures);
+    arena_free(&ren->arena);
+    if(ren->frame_ubo) glDeleteBuffers(1, &ren->frame_ubo);
+    allocator_free(ren->allocator, ren, sizeof(*ren));
+}
+
+static void shader_reflect_uniforms(Renderer *ren, Shader *shader)
+{
+    GLint count = 0;
+    glGetProgramiv(shader->program, GL_ACTIVE_UNIFORMS, &count);
+    if(count <= 0) return;
+    // The count is known up front, so size the table exactly instead of
+    // letting a dynamic array start at DA_INIT_CAP entries
+    shader->uniforms.items = arena_push_array(&ren->arena, Uniform, count);
+    shader->uniforms.capacity = count;
+    shader->uniform_table.arena = &ren->arena;
+    uniform_table_reserve(&shader->uniform_table, count);
+    for(GLint i = 0; i < count; ++i) {
+        char name[256];
+        GLsizei len = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(shader->program, i, sizeof(name), &len, &size, &type, name);
+        // Arrays are reported as "name[0]", make them findable as "name"
+        if(len > 3 && memcmp(name + len - 3, "[0]", 3) == 0) {
+            len -= 3;
+            name[len] = '\0';
+        }
+        // Members of uniform blocks have no location
+        GLint loc = glGetUniformLocation(shader->program, name);
+        if(loc < 0) continue;
+        Uniform *uniform = &shader->uniforms.items[shader->uniforms.count++];
+        *uniform = (Uniform){
+            .name = sv_from_parts(arena_strndup(&ren->arena, name, len), len),
+            .location = loc,
+            .type = type,
+            .size = size,
+        };
+        uniform_table_put(&shader->uniform_table, uniform->name, (UniformID)shader->uniforms.count);
+    }
 }
 
 ShaderID render_create_shader(Renderer *ren, ShaderDesc desc)
@@ -97,58 +210,130 @@ ShaderID render_create_shader(Renderer *ren, ShaderDesc desc)
     glDeleteShader(fsmod);
 
     ShaderID id = ren->shaders.count;
-    da_append(&ren->shaders, ((Shader){
+    allocator_da_append(ren->allocator, &ren->shaders, ((Shader){
         .init = 1,
         .program = shader_program,
     }));
+    shader_reflect_uniforms(ren, &ren->shaders.items[id]);
+    GLuint frame_block = glGetUniformBlockIndex(shader_program, "FrameData");
+    if(frame_block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shader_program, frame_block, RENDER_FRAME_DATA_BINDING);
+    }
     return id;
 }
 
 void shader_use(Renderer *render, ShaderID id)
 {
     Shader shader = render->shaders.items[id];
-    if(shader.init) {
-        glUseProgram(shader.program);
-    } else {
-        glUseProgram(0);
+    GLuint program = shader.init ? shader.program : 0;
+    if(state_update(render, &render->state.program, program)) {
+        glUseProgram(program);
     }
 }
 
-int shader_get_uniform_location(Renderer *render, ShaderID id, const char *name)
+UniformID shader_get_uniform(Renderer *render, ShaderID id, const char *name)
 {
-    Shader shader = render->shaders.items[id];
-    if(shader.init) {
-        int loc = glGetUniformLocation(shader.program, name);
-        if(loc < 0) {
-            DEBUG_ERROR("Failed to get uniform with name: %s\n", name);
-            return -1;
+    Shader *shader = &render->shaders.items[id];
+    if(!shader->init) return INVALID_ID;
+    UniformID *uniform = uniform_table_get(&shader->uniform_table, sv_from_cstr(name));
+    if(!uniform) {
+        DEBUG_ERROR("Failed to get uniform with name: %s\n", name);
+        return INVALID_ID;
+    }
+    return *uniform;
+}
+
+static Uniform *shader_uniform(Renderer *render, ShaderID id, UniformID uniform)
+{
+    Shader *shader = &render->shaders.items[id];
+    if(!shader->init || uniform == INVALID_ID || uniform > shader->uniforms.count) return NULL;
+    return &shader->uniforms.items[uniform - 1];
+}
+
+// Same as state_update for uniform values, which GL keeps per program.
+// glUniform* writes to the bound program, so when `id` isn't the bound one
+// its cache is left alone and whatever the bound program cached for that
+// location is forgotten.
+static bool uniform_update(Renderer *ren, ShaderID id, Uniform *uniform, const float *value, size_t count)
+{
+    if(ren->state.program != ren->shaders.items[id].program) {
+        DEBUG_ERROR("Setting uniform "SV_Fmt" of shader %u while it is not bound", SV_Arg(uniform->name), id);
+        for(size_t i = 1; i < ren->shaders.count; ++i) {
+            Shader *bound = &ren->shaders.items[i];
+            if(bound->program != ren->state.program) continue;
+            for(size_t j = 0; j < bound->uniforms.count; ++j) {
+                if(bound->uniforms.items[j].location == uniform->location) bound->uniforms.items[j].cached = 0;
+            }
         }
-        return loc;
+        ren->stats.issued += 1;
+        return true;
+    }
+    if(uniform->cached && memcmp(uniform->value, value, count*sizeof(*value)) == 0) {
+        ren->stats.elided += 1;
+        return false;
     }
-    return -1;
+    memcpy(uniform->value, value, count*sizeof(*value));
+    uniform->cached = 1;
+    ren->stats.issued += 1;
+    return true;
 }
 
-BOOL shader_set_uniform_vec3(Renderer *ren, ShaderID shader, const char *name, Vec3 vec)
+int shader_get_uniform_location(Renderer *render, ShaderID id, const char *name)
+{
+    Uniform *uniform = shader_uniform(render, id, shader_get_uniform(render, id, name));
+    return uniform ? uniform->location : -1;
+}
+
+BOOL shader_set_vec3(Renderer *ren, ShaderID shader, UniformID id, Vec3 vec)
 {
-    int loc = shader_get_uniform_location(ren, shader, name);
-    if(loc < 0) return FALSE;
-    glUniform3fv(loc, 1, (GLfloat*)&vec);
+    Uniform *uniform = shader_uniform(ren, shader, id);
+    if(!uniform) return FALSE;
+    if(uniform_update(ren, shader, uniform, &vec.x, 3)) glUniform3fv(uniform->location, 1, &vec.x);
     return TRUE;
 }
 
-BOOL shader_set_uniform_mat4(Renderer *ren, ShaderID shader, const char *name, Mat4 mat)
+BOOL shader_set_mat3(Renderer *ren, ShaderID shader, UniformID id, Mat3 mat)
 {
-    int loc = shader_get_uniform_location(ren, shader, name);
-    if(loc < 0) return FALSE;
-    glUniformMatrix4fv(loc, 1, GL_FALSE, mat.data);
+    Uniform *uniform = shader_uniform(ren, shader, id);
+    if(!uniform) return FALSE;
+    if(uniform_update(ren, shader, uniform, mat.data, 9)) glUniformMatrix3fv(uniform->location, 1, GL_FALSE, mat.data);
     return TRUE;
 }
 
+BOOL shader_set_mat4(Renderer *ren, ShaderID shader, UniformID id, Mat4 mat)
+{
+    Uniform *uniform = shader_uniform(ren, shader, id);
+    if(!uniform) return FALSE;
+    if(uniform_update(ren, shader, uniform, mat.data, 16)) glUniformMatrix4fv(uniform->location, 1, GL_FALSE, mat.data);
+    return TRUE;
+}
+
+BOOL shader_set_uniform_vec3(Renderer *ren, ShaderID shader, const char *name, Vec3 vec)
+{
+    return shader_set_vec3(ren, shader, shader_get_uniform(ren, shader, name), vec);
+}
+
+BOOL shader_set_uniform_mat3(Renderer *ren, ShaderID shader, const char *name, Mat3 mat)
+{
+    return shader_set_mat3(ren, shader, shader_get_uniform(ren, shader, name), mat);
+}
+
+BOOL shader_set_uniform_mat4(Renderer *ren, ShaderID shader, const char *name, Mat4 mat)
+{
+    return shader_set_mat4(ren, shader, shader_get_uniform(ren, shader, name), mat);
+}
+
 TextureID render_create_texture_from_file(Renderer *render, const char *filepath)
 {
+    FileView file;
+    if(!file_view_open(filepath, &file)) {
+        DEBUG_ERROR("Failed to open file: %s", filepath);
+        return INVALID_ID;
+    }
     stbi_set_flip_vertically_on_load(true);
     int width, height, nchannels;
-    uint8_t *pixels = stbi_load(filepath, &width, &height, &nchannels, 0);
+    uint8_t *pixels = stbi_load_from_memory((const stbi_uc*)file.data, (int)file.size, &width, &height, &nchannels, 0);
+    file_view_close(&file);
     if(!pixels) {
         DEBUG_ERROR("Failed to load file: %s", filepath);
         return INVALID_ID;
@@ -163,14 +348,23 @@ TextureID render_create_texture_from_file(Renderer *render, const char *filepath
     return texture;
 }
 
+static void render_bind_texture_unit(Renderer *ren, uint32_t unit, GLuint texture)
+{
+    CUT_ASSERT(unit < MAX_TEXTURE_UNITS);
+    if(!state_update(ren, &ren->state.textures[unit], texture)) return;
+    if(state_update(ren, &ren->state.active_texture_unit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
 TextureID render_create_texture(Renderer *ren, TextureDesc desc)
 {
     GLenum internal_format = desc.nchannels == 4 ? GL_RGBA  : GL_RGB;
     GLenum source_format   = desc.nchannels == 4 ? GL_RGBA  : GL_RGB;
     GLuint texture;
     glGenTextures(1, &texture);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    render_bind_texture_unit(ren, 0, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, internal_format, desc.width, desc.height, 0, source_format, GL_UNSIGNED_BYTE, desc.pixels);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
@@ -179,7 +373,7 @@ TextureID render_create_texture(Renderer *ren, TextureDesc desc)
     glGenerateMipmap(GL_TEXTURE_2D);
 
     TextureID id = ren->textures.count;
-    da_append(&ren->textures, ((Texture){
+    allocator_da_append(ren->allocator, &ren->textures, ((Texture){
         .init = 1,
         .texture = texture,
     }));
@@ -201,6 +395,108 @@ BOOL texture_get_opengl_id(Renderer *render, TextureID id, uint32_t *opengl_id)
     return TRUE;
 }
 
+void render_begin_frame(Renderer *ren)
+{
+    ren->last_frame_stats = ren->stats;
+    ren->stats = (RenderStats){0};
+}
+
+RenderStats render_get_stats(Renderer *ren)
+{
+    return ren->last_frame_stats;
+}
+
+void render_invalidate_state(Renderer *ren)
+{
+    RenderState *state = &ren->state;
+    state->program = STATE_UNKNOWN;
+    state->vertex_array = STATE_UNKNOWN;
+    state->array_buffer = STATE_UNKNOWN;
+    state->element_array_buffer = STATE_UNKNOWN;
+    state->uniform_buffer = STATE_UNKNOWN;
+    state->active_texture_unit = STATE_UNKNOWN;
+    for(size_t i = 0; i < MAX_TEXTURE_UNITS; ++i) state->textures[i] = STATE_UNKNOWN;
+    state->depth_test = STATE_UNKNOWN;
+    state->blend = STATE_UNKNOWN;
+    // Raw GL or a lost context may have changed uniform values as well
+    for(size_t i = 0; i < ren->shaders.count; ++i) {
+        Shader *shader = &ren->shaders.items[i];
+        for(size_t j = 0; j < shader->uniforms.count; ++j) shader->uniforms.items[j].cached = 0;
+    }
+}
+
+void render_bind_vertex_array(Renderer *ren, uint32_t vao)
+{
+    if(state_update(ren, &ren->state.vertex_array, vao)) {
+        glBindVertexArray(vao);
+        ren->state.element_array_buffer = STATE_UNKNOWN;
+    }
+}
+
+void render_bind_buffer(Renderer *ren, uint32_t target, uint32_t buffer)
+{
+    GLuint *slot;
+    switch(target) {
+    case GL_ARRAY_BUFFER:         slot = &ren->state.array_buffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER: slot = &ren->state.element_array_buffer; break;
+    case GL_UNIFORM_BUFFER:       slot = &ren->state.uniform_buffer; break;
+    default:
+        // Not tracked, always issued
+        ren->stats.issued += 1;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if(state_update(ren, slot, buffer)) glBindBuffer(target, buffer);
+}
+
+void render_bind_texture(Renderer *ren, uint32_t unit, TextureID id)
+{
+    Texture texture = ren->textures.items[id];
+    render_bind_texture_unit(ren, unit, texture.init ? texture.texture : 0);
+}
+
+static void render_set_capability(Renderer *ren, GLuint *slot, GLenum cap, BOOL enabled)
+{
+    if(!state_update(ren, slot, enabled ? 1 : 0)) return;
+    if(enabled) glEnable(cap);
+    else glDisable(cap);
+}
+
+void render_set_depth_test(Renderer *ren, BOOL enabled)
+{
+    render_set_capability(ren, &ren->state.depth_test, GL_DEPTH_TEST, enabled);
+}
+
+void render_set_blend(Renderer *ren, BOOL enabled)
+{
+    render_set_capability(ren, &ren->state.blend, GL_BLEND, enabled);
+}
+
+void render_update_frame(Renderer *ren, FrameDesc desc)
+{
+    FrameData data = {
+        .view = desc.view,
+        .projection = desc.projection,
+        .view_proj = mat4_dot(desc.projection, desc.view),
+        .camera_pos = vec4(desc.camera_pos.x, desc.camera_pos.y, desc.camera_pos.z, 1.0f),
+        .light_pos = vec4(desc.light_pos.x, desc.light_pos.y, desc.light_pos.z, 1.0f),
+        .light_color = vec4(desc.light_color.x, desc.light_color.y, desc.light_color.z, 1.0f),
+    };
+    if(!ren->frame_ubo) {
+        glGenBuffers(1, &ren->frame_ubo);
+        render_bind_buffer(ren, GL_UNIFORM_BUFFER, ren->frame_ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(data), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, RENDER_FRAME_DATA_BINDING, ren->frame_ubo);
+    } else if(memcmp(&ren->frame_data, &data, sizeof(data)) == 0) {
+        ren->stats.elided += 1;
+        return;
+    }
+    ren->frame_data = data;
+    render_bind_buffer(ren, GL_UNIFORM_BUFFER, ren->frame_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+    ren->stats.issued += 1;
+}
+
 Camera create_perspective_camera(Vec3 pos, uint32_t window_width, uint32_t window_height, float near, float far, float fov_radians)
 {
     Camera cam = {0};
@@ -15,12 +15,53 @@
 #endif
 
 typedef struct Renderer Renderer;
+typedef struct Allocator Allocator;
 
-Renderer *render_init(void);
+// All renderer bookkeeping goes through `allocator`, NULL means the heap
+Renderer *render_init(Allocator *allocator);
 void render_close(Renderer *render);
 
+// The renderer caches the GL state it sets and skips calls that would not
+// change it. Go through the render_bind_* and render_set_* functions
+// instead of raw GL, or call render_invalidate_state after raw GL calls.
+typedef struct RenderStats {
+    uint32_t issued;
+    uint32_t elided;
+} RenderStats;
+// Starts counting a new frame
+void render_begin_frame(Renderer *render);
+// Counts of the previous frame
+RenderStats render_get_stats(Renderer *render);
+void render_invalidate_state(Renderer *render);
+void render_bind_vertex_array(Renderer *render, uint32_t vao);
+void render_bind_buffer(Renderer *render, uint32_t target, uint32_t buffer);
+void render_set_depth_test(Renderer *render, BOOL enabled);
+void render_set_blend(Renderer *render, BOOL enabled);
+
 #define INVALID_ID 0
 
+// Per-frame data every shader can read through this std140 block, which
+// render_create_shader binds to RENDER_FRAME_DATA_BINDING:
+//
+//     layout (std140) uniform FrameData {
+//         mat4 view;
+//         mat4 projection;
+//         mat4 view_proj;
+//         vec4 camera_pos;
+//         vec4 light_pos;
+//         vec4 light_color;
+//     };
+#define RENDER_FRAME_DATA_BINDING 0
+typedef struct {
+    Mat4 view;
+    Mat4 projection;
+    Vec3 camera_pos;
+    Vec3 light_pos;
+    Vec3 light_color;
+} FrameDesc;
+// Uploads the FrameData block once, view_proj is projection * view
+void render_update_frame(Renderer *render, FrameDesc desc);
+
 typedef uint32_t ShaderID;
 typedef struct {
     const char *vert_glsl_source;
@@ -29,7 +70,15 @@ typedef struct {
 ShaderID render_create_shader(Renderer *render, ShaderDesc desc);
 void shader_use(Renderer *render, ShaderID shader);
 int  shader_get_uniform_location(Renderer *render, ShaderID shader, const char *name);
+// Active uniforms are looked up once at shader creation. Resolve the
+// handles up front and set through them to skip the name lookup per draw.
+typedef uint32_t UniformID;
+UniformID shader_get_uniform(Renderer *render, ShaderID shader, const char *name);
+BOOL shader_set_vec3(Renderer *render, ShaderID shader, UniformID uniform, Vec3 vec);
+BOOL shader_set_mat3(Renderer *render, ShaderID shader, UniformID uniform, Mat3 mat);
+BOOL shader_set_mat4(Renderer *render, ShaderID shader, UniformID uniform, Mat4 mat);
 BOOL shader_set_uniform_vec3(Renderer *rendere, ShaderID shader, const char *name, Vec3 vec);
+BOOL shader_set_uniform_mat3(Renderer *rendere, ShaderID shader, const char *name, Mat3 mat);
 BOOL shader_set_uniform_mat4(Renderer *rendere, ShaderID shader, const char *name, Mat4 mat);
 
 typedef uint32_t TextureID;
@@ -42,6 +91,8 @@ typedef struct {
 TextureID render_create_texture_from_file(Renderer *render, const char *filepath);
 TextureID render_create_texture(Renderer *render, TextureDesc desc);
 BOOL texture_get_opengl_id(Renderer *render, TextureID texture, uint32_t *opengl_id);
+// Binds `texture` as GL_TEXTURE_2D on texture unit `unit`
+void render_bind_texture(Renderer *render, uint32_t unit, TextureID texture);
 
 typedef uint32_t MeshID;
 MeshID render_create_mesh(Renderer *render);
@@ -66,21 +66,21 @@ void process_input(GLFWwindow *window)
         }
     }
 
-    camera_update_direction(&camera, vec3(
-        cos(DEG2RAD(yaw)) * cos(DEG2RAD(pitch)),
-        sin(DEG2RAD(pitch)),
-        sin(DEG2RAD(yaw)) * cos(DEG2RAD(pitch))
-    ));
+    float sin_yaw, cos_yaw, sin_pitch, cos_pitch;
+    gm_sincos_fast((float)DEG2RAD(yaw), &sin_yaw, &cos_yaw);
+    gm_sincos_fast((float)DEG2RAD(pitch), &sin_pitch, &cos_pitch);
+    camera_update_direction(&camera, vec3(cos_yaw*cos_pitch, sin_pitch, sin_yaw*cos_pitch));
 
     const float camera_speed = 2.5f * delta_time;
     if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) 
         camera.pos = vec3_add(camera.pos, vec3_mul_scalar(camera.front, camera_speed));
     if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) 
         camera.pos = vec3_sub(camera.pos, vec3_mul_scalar(camera.front, camera_speed));
+    Vec3 camera_right = vec3_normalize_fast(vec3_cross(camera.front, camera.up));
     if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) 
-        camera.pos = vec3_sub(camera.pos, vec3_mul_scalar(vec3_normalize(vec3_cross(camera.front, camera.up)), camera_speed));
+        camera.pos = vec3_sub(camera.pos, vec3_mul_scalar(camera_right, camera_speed));
     if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) 
-        camera.pos = vec3_add(camera.pos, vec3_mul_scalar(vec3_normalize(vec3_cross(camera.front, camera.up)), camera_speed));
+        camera.pos = vec3_add(camera.pos, vec3_mul_scalar(camera_right, camera_speed));
 }
 
 int main(void)
@@ -99,12 +99,12 @@ int main(void)
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
 
-    glEnable(GL_DEPTH_TEST);
+    TrackingAllocator renderer_allocator, assets_allocator;
+    Renderer *ren = render_init(tracking_allocator_init(&renderer_allocator, "renderer", NULL));
+    render_set_depth_test(ren, TRUE);
 
-    Renderer *ren = render_init();
-
-    StringBuilder vert = {0};
-    StringBuilder frag = {0};
+    StringBuilder vert = { .allocator = tracking_allocator_init(&assets_allocator, "assets", NULL) };
+    StringBuilder frag = { .allocator = vert.allocator };
     if(!read_entire_file("assets/shaders/1.color_cube.vert", &vert)) return -1;
     if(!read_entire_file("assets/shaders/1.color_cube.frag", &frag)) return -1;
     ShaderID lighting_shader = render_create_shader(ren, (ShaderDesc){
@@ -125,6 +125,20 @@ int main(void)
     vert.count = 0;
     frag.count = 0;
 
+    // Camera and light come from the FrameData block, these are per object
+    struct {
+        UniformID object_color, model, normal_matrix;
+    } lighting = {
+        .object_color  = shader_get_uniform(ren, lighting_shader, "objectColor"),
+        .model         = shader_get_uniform(ren, lighting_shader, "model"),
+        .normal_matrix = shader_get_uniform(ren, lighting_shader, "normalMatrix"),
+    };
+    struct {
+        UniformID model;
+    } light_cube = {
+        .model = shader_get_uniform(ren, light_cube_shader, "model"),
+    };
+
     Vertex vertices[] = {
         { .pos = { -0.5f, -0.5f, -0.5f }, .normal = { 0.0f, 0.0f, -1.0f, }, }, 
         { .pos = { +0.5f, -0.5f, -0.5f }, .normal = { 0.0f, 0.0f, -1.0f, }, }, 
@@ -169,19 +183,19 @@ int main(void)
 
     GLuint vbo = 0;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    render_bind_buffer(ren, GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     GLuint ibo = 0;
     glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    render_bind_buffer(ren, GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     GLuint color_cube_vao = 0;
     glGenVertexArrays(1, &color_cube_vao);
-    glBindVertexArray(color_cube_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    render_bind_vertex_array(ren, color_cube_vao);
+    render_bind_buffer(ren, GL_ARRAY_BUFFER, vbo);
+    render_bind_buffer(ren, GL_ELEMENT_ARRAY_BUFFER, ibo);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
     glEnableVertexAttribArray(1);
@@ -189,9 +203,9 @@ int main(void)
 
     GLuint light_cube_vao = 0;
     glGenVertexArrays(1, &light_cube_vao);
-    glBindVertexArray(light_cube_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    render_bind_vertex_array(ren, light_cube_vao);
+    render_bind_buffer(ren, GL_ARRAY_BUFFER, vbo);
+    render_bind_buffer(ren, GL_ELEMENT_ARRAY_BUFFER, ibo);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
 
@@ -200,7 +214,10 @@ int main(void)
 
     Mat4 view;
     Mat4 model;
+    const AABB cube_bounds = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
     while(!glfwWindowShouldClose(window)) {
+        frame_arena_begin();
+        render_begin_frame(ren);
         float current_frame = glfwGetTime();
         delta_time = current_frame - last_frame;
         last_frame = current_frame;
@@ -209,37 +226,51 @@ int main(void)
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         view  = camera_get_view_matrix(camera);
+        render_update_frame(ren, (FrameDesc){
+            .view = view,
+            .projection = camera.projection,
+            .camera_pos = camera.pos,
+            .light_pos = light_pos,
+            .light_color = vec3(1.0f, 1.0f, 1.0f),
+        });
+        Frustum frustum = frustum_from_view_proj(mat4_dot(camera.projection, view));
 
         shader_use(ren, lighting_shader);
-        shader_set_uniform_vec3(ren, lighting_shader, "objectColor", vec3(1.0f, 0.5f, 0.31f));
-        shader_set_uniform_vec3(ren, lighting_shader, "lightColor",  vec3(1.0f, 1.0f, 1.0));
-        shader_set_uniform_vec3(ren, lighting_shader, "lightPos",  light_pos);
-        shader_set_uniform_vec3(ren, lighting_shader, "viewPos",  camera.pos);
+        shader_set_vec3(ren, lighting_shader, lighting.object_color, vec3(1.0f, 0.5f, 0.31f));
         model = mat4_eye(1.0f);
         model = mat4_translate(model, vec3(0.0f, 0.0f, 0.0f));
-        shader_set_uniform_mat4(ren, lighting_shader, "view", view);
-        shader_set_uniform_mat4(ren, lighting_shader, "projection", camera.projection);
-        shader_set_uniform_mat4(ren, lighting_shader, "model", model);
-        glBindVertexArray(color_cube_vao);
-        glDrawElements(GL_TRIANGLES, ARRAY_LEN(indices), GL_UNSIGNED_INT, 0);
+        shader_set_mat4(ren, lighting_shader, lighting.model, model);
+        shader_set_mat3(ren, lighting_shader, lighting.normal_matrix, mat3_normal_from_mat4(model));
+        if(frustum_test_aabb(&frustum, aabb_transform(cube_bounds, model))) {
+            render_bind_vertex_array(ren, color_cube_vao);
+            glDrawElements(GL_TRIANGLES, ARRAY_LEN(indices), GL_UNSIGNED_INT, 0);
+        }
 
         shader_use(ren, light_cube_shader);
-        shader_set_uniform_mat4(ren, light_cube_shader, "view", view);
-        shader_set_uniform_mat4(ren, light_cube_shader, "projection", camera.projection);
         model = mat4_eye(1.0f);
         model = mat4_translate(model, light_pos);
         model = mat4_scale(model, vec3(0.2f, 0.2f, 0.2f));
-        shader_set_uniform_mat4(ren, light_cube_shader, "model", model);
-        glBindVertexArray(light_cube_vao);
-        glDrawElements(GL_TRIANGLES, ARRAY_LEN(indices), GL_UNSIGNED_INT, 0);
+        shader_set_mat4(ren, light_cube_shader, light_cube.model, model);
+        if(frustum_test_aabb(&frustum, aabb_transform(cube_bounds, model))) {
+            render_bind_vertex_array(ren, light_cube_vao);
+            glDrawElements(GL_TRIANGLES, ARRAY_LEN(indices), GL_UNSIGNED_INT, 0);
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    da_free(&vert);
-    da_free(&frag);
+#ifndef NDEBUG
+    RenderStats stats = render_get_stats(ren);
+    fprintf(stderr, "INFO: last frame issued %u GL state calls, elided %u\n", stats.issued, stats.elided);
+#endif
+    sb_free(&vert);
+    sb_free(&frag);
     render_close(ren);
+    frame_arena_thread_free();
+#ifndef NDEBUG
+    tracking_allocator_report(stderr);
+#endif
     glfwTerminate();
     return 0;
 }
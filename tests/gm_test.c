@@ -0,0 +1,134 @@
+#define GM_IMPLEMENTATION
+#include "gm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks the gm.h fast paths against the straightforward mat4_dot products
+// they replace. Built and run by `make test`, exits non-zero on failure.
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if(!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures += 1;                                                  \
+        }                                                                   \
+    } while(0)
+
+static bool mat4_near(Mat4 a, Mat4 b)
+{
+    for(int i = 0; i < 16; ++i) {
+        float scale = fmaxf(1.0f, fmaxf(fabsf(a.data[i]), fabsf(b.data[i])));
+        if(fabsf(a.data[i] - b.data[i]) > 1e-5f*scale) return false;
+    }
+    return true;
+}
+
+static Mat4 translation_matrix(Vec3 v)
+{
+    Mat4 t = mat4_eye(1.0f);
+    t.data[3] = v.x;
+    t.data[7] = v.y;
+    t.data[11] = v.z;
+    return t;
+}
+
+static Mat4 scale_matrix(Vec3 s)
+{
+    Mat4 m = mat4_eye(1.0f);
+    m.data[0] = s.x;
+    m.data[5] = s.y;
+    m.data[10] = s.z;
+    return m;
+}
+
+// The matrix the in-place helpers post-multiply by, built the long way
+static Mat4 rotation_matrix(int i, int j, float angle_radians)
+{
+    Mat4 r = mat4_eye(1.0f);
+    float s = sinf(angle_radians);
+    float c = cosf(angle_radians);
+    r.data[i*4 + i] = c;
+    r.data[j*4 + j] = c;
+    r.data[i*4 + j] = -s;
+    r.data[j*4 + i] = s;
+    return r;
+}
+
+// A projection times a view, so the last row is not 0 0 0 1
+static Mat4 general_matrix(void)
+{
+    return mat4_dot(mat4_perspective((float)DEG2RAD(60.0f), 16.0f/9.0f, 0.1f, 100.0f),
+            mat4_look_at(vec3(3.0f, 2.0f, 5.0f), vec3(0.0f, 0.5f, 0.0f), vec3(0.0f, 1.0f, 0.0f)));
+}
+
+static Mat4 affine_matrix(void)
+{
+    Mat4 model = mat4_dot(translation_matrix(vec3(1.5f, -2.0f, 0.25f)), rotation_matrix(2, 0, 0.4f));
+    model = mat4_dot(model, rotation_matrix(1, 2, -1.1f));
+    return mat4_dot(model, scale_matrix(vec3(2.0f, 0.5f, -3.0f)));
+}
+
+static void test_mat4_in_place_transforms(void)
+{
+    Mat4 general = general_matrix();
+    Vec3 v = vec3(1.5f, -2.0f, 0.25f);
+    Vec3 s = vec3(2.0f, 0.5f, -3.0f);
+    float angle = 0.7f;
+    CHECK(mat4_near(mat4_translate(general, v), mat4_dot(general, translation_matrix(v))));
+    CHECK(mat4_near(mat4_scale(general, s), mat4_dot(general, scale_matrix(s))));
+    CHECK(mat4_near(mat4_rotate_x(general, angle), mat4_dot(general, rotation_matrix(1, 2, angle))));
+    CHECK(mat4_near(mat4_rotate_y(general, angle), mat4_dot(general, rotation_matrix(2, 0, angle))));
+    CHECK(mat4_near(mat4_rotate_z(general, angle), mat4_dot(general, rotation_matrix(0, 1, angle))));
+}
+
+static void test_affine3_transforms(void)
+{
+    Mat4 model = affine_matrix();
+    Affine3 affine = affine3_from_mat4(model);
+    Vec3 v = vec3(-0.5f, 4.0f, 2.0f);
+    Vec3 s = vec3(0.25f, 3.0f, 1.5f);
+    float angle = -2.3f;
+    CHECK(mat4_near(mat4_from_affine3(affine3_translate(affine, v)), mat4_dot(model, translation_matrix(v))));
+    CHECK(mat4_near(mat4_from_affine3(affine3_scale(affine, s)), mat4_dot(model, scale_matrix(s))));
+    CHECK(mat4_near(mat4_from_affine3(affine3_rotate_x(affine, angle)), mat4_dot(model, rotation_matrix(1, 2, angle))));
+    CHECK(mat4_near(mat4_from_affine3(affine3_rotate_y(affine, angle)), mat4_dot(model, rotation_matrix(2, 0, angle))));
+    CHECK(mat4_near(mat4_from_affine3(affine3_rotate_z(affine, angle)), mat4_dot(model, rotation_matrix(0, 1, angle))));
+    CHECK(mat4_near(mat4_from_affine3(affine3_dot(affine, affine)), mat4_dot(model, model)));
+
+    Vec3 p = vec3(0.3f, -1.2f, 5.0f);
+    Vec4 expected = mat4_mul_vec4(model, vec4(p.x, p.y, p.z, 1.0f));
+    Vec3 got = affine3_mul_point(affine, p);
+    CHECK(fabsf(got.x - expected.x) < 1e-5f && fabsf(got.y - expected.y) < 1e-5f && fabsf(got.z - expected.z) < 1e-5f);
+}
+
+static void test_inverse_and_normal_matrix(void)
+{
+    Mat4 model = affine_matrix();
+    Mat4 inverse = mat4_inverse_affine(model);
+    CHECK(mat4_near(mat4_dot(inverse, model), mat4_eye(1.0f)));
+    CHECK(mat4_near(mat4_dot(model, inverse), mat4_eye(1.0f)));
+
+    // The normal matrix is the transposed inverse of the upper 3x3
+    Mat3 normal = mat3_normal_from_mat4(model);
+    for(int i = 0; i < 3; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            CHECK(fabsf(normal.data[i*3 + j] - inverse.data[j*4 + i]) < 1e-5f);
+        }
+    }
+}
+
+int main(void)
+{
+    test_mat4_in_place_transforms();
+    test_affine3_transforms();
+    test_inverse_and_normal_matrix();
+    if(failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("gm_test: all checks passed\n");
+    return 0;
+}